@@ -0,0 +1,46 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file LoaderBench.h */
+
+#ifndef __LOADERBENCH_H
+#define __LOADERBENCH_H
+
+#include <QObject>
+
+namespace QComicBook
+{
+    class Page;
+
+    //! Counts pages delivered by PageLoaderThread in two-pages mode.
+    class PageCounter: public QObject
+    {
+        Q_OBJECT
+
+        signals:
+            //! Emitted once the expected number of pages was delivered.
+            void done();
+
+        public slots:
+            void pageLoaded(const Page &p1, const Page &p2);
+
+        public:
+            PageCounter(int expected);
+            int pages() const;
+
+        private:
+            int expected;
+            int count;
+    };
+}
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include <QApplication>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QImage>
+#include <QPainter>
+#include <QSharedPointer>
+#include <stdlib.h>
+#include "LoaderBench.h"
+#include "PageLoaderThread.h"
+#include "Page.h"
+#include "Sink/ImgDirSink.h"
+
+//
+// Decodes every page of a directory in two-pages mode, first with a single loader
+// thread and then with a pool of workers, and reports pages per second for both.
+//   loader_bench [directory [workers]]
+// Without a directory, pages are generated in a temporary one.
+
+using namespace QComicBook;
+
+static const int GENERATED_PAGES = 48;
+static const int GENERATED_WIDTH = 1200;
+static const int GENERATED_HEIGHT = 1800;
+
+PageCounter::PageCounter(int expected): QObject(), expected(expected), count(0)
+{
+}
+
+void PageCounter::pageLoaded(const Page &, const Page &)
+{
+    count += 2;
+    if (count >= expected)
+    {
+        emit done();
+    }
+}
+
+int PageCounter::pages() const
+{
+    return count;
+}
+
+//
+// noise keeps the PNGs from compressing to nothing, so decoding does real work
+static bool generatePages(const QString &path)
+{
+    srand(12345);
+    for (int i = 0; i < GENERATED_PAGES; ++i)
+    {
+        QImage img(GENERATED_WIDTH, GENERATED_HEIGHT, QImage::Format_RGB32);
+        for (int y = 0; y < img.height(); ++y)
+        {
+            QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+            for (int x = 0; x < img.width(); ++x)
+            {
+                const int v = (x + y + i * 16) & 0xff;
+                line[x] = qRgb(v, (v + rand() % 32) & 0xff, 255 - v);
+            }
+        }
+        QPainter p(&img);
+        p.drawText(img.rect(), Qt::AlignCenter, QString::number(i + 1));
+        p.end();
+        if (!img.save(QString("%1/page%2.png").arg(path).arg(i + 1, 3, 10, QChar('0')), "PNG"))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// returns pages per second, or a negative value if the directory can't be opened
+static double run(const QString &path, int workers, int *pages)
+{
+    QSharedPointer<ImgSink> sink(new ImgDirSink());
+    if (sink->open(path) != 0 || sink->numOfImages() < 2)
+    {
+        return -1.0;
+    }
+    const int n = sink->numOfImages() & ~1;
+
+    PageLoaderThread *loader = new PageLoaderThread(workers);
+    loader->setSink(sink);
+    loader->start();
+
+    PageCounter counter(n);
+    QEventLoop loop;
+    QObject::connect(loader, SIGNAL(pageLoaded(const Page&, const Page&)), &counter, SLOT(pageLoaded(const Page&, const Page&)));
+    QObject::connect(&counter, SIGNAL(done()), &loop, SLOT(quit()));
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < n; i += 2)
+    {
+        loader->requestTwoPages(i);
+    }
+    loop.exec();
+    const qint64 ms = qMax(timer.elapsed(), qint64(1));
+
+    loader->stop();
+    loader->wait();
+    delete loader;
+
+    *pages = counter.pages();
+    return counter.pages() * 1000.0 / ms;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    qRegisterMetaType<Page>("Page");
+
+    const QStringList args = app.arguments();
+    QTemporaryDir tmp;
+    QString path;
+    if (args.size() > 1)
+    {
+        path = args.at(1);
+    }
+    else
+    {
+        if (!tmp.isValid() || !generatePages(tmp.path()))
+        {
+            out << "can't generate pages" << endl;
+            return 1;
+        }
+        path = tmp.path();
+    }
+    const int workers = args.size() > 2 ? args.at(2).toInt() : QThread::idealThreadCount();
+    if (workers < 1)
+    {
+        out << "usage: " << args.at(0) << " [directory [workers]]" << endl;
+        return 2;
+    }
+
+    //
+    // the first pass only warms the file cache, so both measured runs decode from memory
+    int pages1, pagesK;
+    run(path, workers, &pagesK);
+    const double single = run(path, 1, &pages1);
+    const double pool = run(path, workers, &pagesK);
+    if (single < 0.0 || pool < 0.0)
+    {
+        out << "can't open " << path << endl;
+        return 1;
+    }
+
+    out << "directory:   " << path << endl;
+    out << "pages:       " << pages1 << endl;
+    out << "1 worker:    " << QString::number(single, 'f', 1) << " pages/s" << endl;
+    out << workers << " workers: " << QString::number(pool, 'f', 1) << " pages/s" << endl;
+    out << "speedup:     " << QString::number(pool / single, 'f', 2) << "x" << endl;
+    return 0;
+}
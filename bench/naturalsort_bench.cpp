@@ -0,0 +1,149 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <stdlib.h>
+#include "NaturalComparator.h"
+
+//
+// Times sorting of a large page listing with the chunk-by-chunk comparator
+// QComicBook used before sort keys, and checks both methods agree on the order.
+
+static const int DEFAULT_COUNT = 50000;
+
+static unsigned toInt(QString const& s, int *idx)
+{
+	int res = 0;
+	int i = *idx;
+	while (i != s.size() && s[i].isDigit())
+	{
+		res *= 10;
+		res += s[i].digitValue();
+		++i;
+	}
+	*idx = i;
+	return res;
+}
+
+//! Alphanum comparator as it was before NaturalComparator::sortKey().
+struct LegacyComparator
+{
+	bool operator()(QString const& l, QString const& r) const
+	{
+		enum Mode { String, Number } mode = String;
+		for (int il = 0, ir = 0; il != l.size() && ir != r.size();)
+		{
+			if (mode == String)
+			{
+				for (; il != l.size() && ir != r.size(); ++il, ++ir)
+				{
+					const bool digitL = l[il].isDigit(), digitR = r[ir].isDigit();
+					if (digitL && digitR)
+					{
+						mode = Number;
+						break;
+					}
+					if (digitL) return true;
+					if (digitR) return false;
+					if (l[il] != r[ir]) return l[il] < r[ir];
+				}
+			}
+			else
+			{
+				unsigned lNum = toInt(l, &il);
+				unsigned rNum = toInt(r, &ir);
+				if (lNum != rNum) return lNum < rNum;
+				mode = String;
+			}
+		}
+		return l.size() < r.size();
+	}
+};
+
+//
+// Names look like real listings: a few series, volume and page numbers of
+// varying width, mixed extensions. Every name is unique and numbers stay
+// well within unsigned range, so both comparators define the same order.
+static QStringList generateNames(int count)
+{
+	static const char *series[] = { "Akira", "Blacksad", "Corto Maltese", "akira", "Tintin v2" };
+	static const char *exts[] = { "jpg", "png", "JPG" };
+
+	QStringList names;
+	names.reserve(count);
+	for (int i = 0; i < count; ++i)
+	{
+		names.append(QString("%1/Vol %2/page%3.%4")
+					 .arg(series[i % 5])
+					 .arg(i / 1000 + 1)
+					 .arg(i % 1000 + 1)
+					 .arg(exts[(i / 7) % 3]));
+	}
+
+	srand(12345);
+	for (int i = names.size() - 1; i > 0; --i)
+	{
+		names.swap(i, rand() % (i + 1));
+	}
+	return names;
+}
+
+int main(int argc, char *argv[])
+{
+	QTextStream out(stdout);
+	int count = DEFAULT_COUNT;
+	if (argc > 1)
+	{
+		count = QString(argv[1]).toInt();
+		if (count <= 0)
+		{
+			out << "usage: " << argv[0] << " [number of names]" << endl;
+			return 2;
+		}
+	}
+
+	const QStringList names = generateNames(count);
+	QElapsedTimer timer;
+
+	QStringList legacy = names;
+	timer.start();
+	std::sort(legacy.begin(), legacy.end(), LegacyComparator());
+	const qint64 legacyMs = timer.elapsed();
+
+	QStringList keyed = names;
+	timer.start();
+	naturalSort(keyed);
+	const qint64 keyedMs = timer.elapsed();
+
+	out << "names:                  " << count << endl;
+	out << "std::sort (old):        " << legacyMs << " ms" << endl;
+	out << "naturalSort (sort key): " << keyedMs << " ms" << endl;
+	if (keyedMs > 0)
+	{
+		out << "speedup:                " << QString::number(double(legacyMs) / keyedMs, 'f', 2) << "x" << endl;
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		if (legacy.at(i) != keyed.at(i))
+		{
+			out << "order mismatch at " << i << ": " << legacy.at(i) << " vs " << keyed.at(i) << endl;
+			return 1;
+		}
+	}
+	out << "order: identical" << endl;
+	return 0;
+}
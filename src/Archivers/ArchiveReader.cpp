@@ -0,0 +1,86 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "ArchiveReader.h"
+#include <QFileInfo>
+#include <QDataStream>
+
+using namespace QComicBook;
+
+ArchiveReader::ArchiveReader()
+{
+}
+
+ArchiveReader::~ArchiveReader()
+{
+}
+
+bool ArchiveReader::reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &)
+{
+    close();
+    if (!QFileInfo(filename).isReadable())
+    {
+        return false;
+    }
+    m_filename = filename;
+    m_entries = entries;
+    return true;
+}
+
+bool ArchiveReader::openData(const QByteArray &)
+{
+    return false;
+}
+
+QByteArray ArchiveReader::indexData() const
+{
+    return QByteArray();
+}
+
+void ArchiveReader::close()
+{
+    m_entries.clear();
+    m_filename = QString::null;
+}
+
+const QList<ArchiveEntry>& ArchiveReader::entries() const
+{
+    return m_entries;
+}
+
+QList<QByteArray> ArchiveReader::readEntries(const QList<int> &entries)
+{
+    QList<QByteArray> data;
+    foreach (int e, entries)
+    {
+        data.append(read(e));
+    }
+    return data;
+}
+
+QString ArchiveReader::fileName() const
+{
+    return m_filename;
+}
+
+QDataStream& QComicBook::operator<<(QDataStream &str, const ArchiveEntry &e)
+{
+    return str << e.name << static_cast<qint32>(e.index) << e.offset << e.compressedSize << e.size;
+}
+
+QDataStream& QComicBook::operator>>(QDataStream &str, ArchiveEntry &e)
+{
+    qint32 idx;
+    str >> e.name >> idx >> e.offset >> e.compressedSize >> e.size;
+    e.index = idx;
+    return str;
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file ArchiveReader.h */
+
+#ifndef __ARCHIVE_READER_H
+#define __ARCHIVE_READER_H
+
+#include <QString>
+#include <QList>
+#include <QByteArray>
+
+class QDataStream;
+
+namespace QComicBook
+{
+    //! Single file stored in an archive.
+    struct ArchiveEntry
+    {
+        QString name; //!< path of the file inside the archive
+        int index; //!< position of the header in archive (stored) order
+        qint64 offset; //!< offset of the entry header in archive file or -1 if not known
+        qint64 compressedSize; //!< size of compressed data or -1 if not known
+        qint64 size; //!< size of uncompressed data or -1 if not known
+
+        ArchiveEntry(): index(-1), offset(-1), compressedSize(-1), size(-1) {}
+    };
+
+    QDataStream& operator<<(QDataStream &str, const ArchiveEntry &e);
+    QDataStream& operator>>(QDataStream &str, ArchiveEntry &e);
+
+	/**
+	 * @brief Base class for archive readers working in-process, without external archivers.
+	 *
+	 * Unlike ArchiverStrategy, which only describes how to invoke external tools, a reader
+	 * provides the list of archive files and random access to contents of any of them.
+	 */
+    class ArchiveReader
+    {
+    public:
+        ArchiveReader();
+        virtual ~ArchiveReader();
+
+		/**
+		 * @brief Opens archive file and reads the list of its files.
+		 *
+		 * @param filename archive filename
+		 *
+		 * @return true on success
+		 */
+        virtual bool open(const QString &filename) = 0;
+
+		/**
+		 * @brief Opens archive held in memory, e.g. an archive stored inside another one.
+		 *
+		 * @param data archive contents; reader keeps a (shallow) copy
+		 *
+		 * @return true on success; false if the format or in-memory reading is not supported
+		 */
+        virtual bool openData(const QByteArray &data);
+
+		/**
+		 * @brief Opens archive file using the list of files obtained earlier by the same kind of reader. The archive is not scanned.
+		 *
+		 * @param filename archive filename
+		 * @param entries entries returned by entries() of a reader with the same name()
+		 * @param data value of indexData() of that reader
+		 *
+		 * @return true on success
+		 */
+        virtual bool reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data);
+
+		/**
+		 * @brief Returns reader specific data worth keeping along with entries, e.g. seek points of compressed stream.
+		 *
+		 * @return opaque data for reopen(); empty by default
+		 */
+        virtual QByteArray indexData() const;
+
+        virtual void close();
+
+		/**
+		 * @brief Returns name of this kind of reader. Entries (indices and offsets) are only meaningful to readers of the same name.
+		 */
+        virtual QString name() const = 0;
+
+		/**
+		 * @brief Returns regular files of the archive, in stored order.
+		 */
+        const QList<ArchiveEntry>& entries() const;
+
+		/**
+		 * @brief Decompresses given file into memory. Has to be safe to call from many threads at once.
+		 *
+		 * @param entry index in the list returned by entries()
+		 *
+		 * @return file contents; empty array on error
+		 */
+        virtual QByteArray read(int entry) = 0;
+
+		/**
+		 * @brief Decompresses given files. Readers of stream formats may serve all of them in one pass over the archive.
+		 *
+		 * @param entries indices in the list returned by entries(), in any order
+		 *
+		 * @return contents of the files, in the order of entries
+		 */
+        virtual QList<QByteArray> readEntries(const QList<int> &entries);
+
+        QString fileName() const;
+
+    protected:
+        QString m_filename;
+        QList<ArchiveEntry> m_entries;
+    };
+}
+
+#endif
@@ -11,6 +11,7 @@
  */
 
 #include "ArchiverStrategy.h"
+#include "FileTypeDetector.h"
 #include <QFile>
 
 using namespace QComicBook;
@@ -18,6 +19,7 @@ using namespace QComicBook;
 ArchiverStrategy::ArchiverStrategy(const QString &name, const FileSignature &sig)
     : name(name)
     , supported(false)
+    , builtin(false)
     , signature(sig)
 {
 }
@@ -31,6 +33,11 @@ void ArchiverStrategy::setSupported(bool f)
     supported = f;
 }
 
+void ArchiverStrategy::setBuiltin(bool f)
+{
+    builtin = f;
+}
+
 void ArchiverStrategy::addExtension(const QString &ext)
 {
     if (extensions.indexOf(ext) < 0)
@@ -71,6 +78,11 @@ void ArchiverStrategy::setListArguments(const QString &command)
     listArgs = command.split(" ", QString::SkipEmptyParts);
 }
 
+void ArchiverStrategy::setListPattern(const QString &pattern)
+{
+    listPattern = QRegExp(pattern);
+}
+
 void ArchiverStrategy::setExecutables(const QString &exec1, const QString &exec2)
 {
     executables.clear();
@@ -101,24 +113,35 @@ QStringList ArchiverStrategy::getListArguments() const
     return listArgs;
 }
 
+QRegExp ArchiverStrategy::getListPattern() const
+{
+    return listPattern;
+}
+
 QStringList ArchiverStrategy::getExtensions() const
 {
     return extensions;
 }
 
+bool ArchiverStrategy::canOpen(const QString &filename, const QByteArray &head) const
+{
+    return supported && signature.matches(head);
+}
+
 bool ArchiverStrategy::canOpen(QFile *f) const
 {
-    return supported && signature.matches(f);
+    return f->seek(0) && canOpen(f->fileName(), f->read(FileTypeDetector::HEAD_SIZE));
 }
 
 bool ArchiverStrategy::canOpen(const QString &filename) const
 {
-    QFile file(filename);
-    if (file.open(QIODevice::ReadOnly))
-    {
-        return canOpen(&file);
-    }
-	return false;
+    const QByteArray head(FileTypeDetector::readHead(filename));
+    return !head.isNull() && canOpen(filename, head);
+}
+
+bool ArchiverStrategy::matchesSignature(const QByteArray &head) const
+{
+    return signature.matches(head);
 }
 
 QList<ArchiverHint> ArchiverStrategy::getHints() const
@@ -131,6 +154,16 @@ bool ArchiverStrategy::isSupported() const
     return supported;
 }
 
+bool ArchiverStrategy::isBuiltin() const
+{
+    return builtin;
+}
+
+ArchiveReader* ArchiverStrategy::createReader() const
+{
+    return NULL; // external archivers can only extract whole archive
+}
+
 ArchiverStrategy::operator ArchiverStatus() const
 {
     Q_ASSERT(executables.size() > 0);
@@ -17,6 +17,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QRegExp>
 #include "FileSignature.h"
 #include "ArchiverHint.h"
 #include "ArchiverStatus.h"
@@ -25,6 +26,8 @@ class QFile;
 
 namespace QComicBook
 {
+    class ArchiveReader;
+
 	/**
 	 * @brief Base class that provides configuration information and commandline parameters for external archivers.
 	 */
@@ -34,6 +37,16 @@ namespace QComicBook
         ArchiverStrategy(const QString &name, const FileSignature &sig);
         virtual ~ArchiverStrategy();
 
+		/**
+		 * @brief Return true if specified archive file can be opened with this archiver.
+		 *
+		 * @param filename archive filename
+		 * @param head leading bytes of the file, see FileTypeDetector::readHead()
+		 *
+		 * @return true if file can be extracted
+		 */
+        virtual bool canOpen(const QString &filename, const QByteArray &head) const;
+
 		/**
 		 * @brief Return true if specified archive file can be opened with this archiver.
 		 *
@@ -41,7 +54,7 @@ namespace QComicBook
 		 *
 		 * @return true if f can be extracted
 		 */
-        virtual bool canOpen(QFile *f) const;
+        bool canOpen(QFile *f) const;
 
 		/**
 		 * @brief Return true if specified archive file can be opened with this archiver.
@@ -50,7 +63,12 @@ namespace QComicBook
 		 *
 		 * @return true if file can be extracted
 		 */
-        virtual bool canOpen(const QString &filename) const;
+        bool canOpen(const QString &filename) const;
+
+		/**
+		 * @brief Return true if head of the file matches signature of this archiver, even if archiver is not supported.
+		 */
+        bool matchesSignature(const QByteArray &head) const;
 
         QStringList getExtractArguments(const QString &filename) const;
         QStringList getExtractArguments() const;
@@ -58,6 +76,13 @@ namespace QComicBook
         QStringList getListArguments() const;
         QStringList getExtensions() const;
 
+		/**
+		 * @brief Returns pattern matching single entry in the output of list command. The first captured text is entry name.
+		 *
+		 * @return pattern or empty regexp if list output can't be parsed
+		 */
+        QRegExp getListPattern() const;
+
 		/**
 		 * @brief Return true if this archiver is supported.
 		 *
@@ -65,6 +90,20 @@ namespace QComicBook
 		 */
         bool isSupported() const;
 
+		/**
+		 * @brief Return true if this archiver works in-process instead of invoking external executables.
+		 *
+		 * @return true if archiver is built-in
+		 */
+        bool isBuiltin() const;
+
+		/**
+		 * @brief Creates in-process reader for archives handled by this archiver. The caller takes ownership.
+		 *
+		 * @return new reader or NULL if archiver is not built-in
+		 */
+        virtual ArchiveReader* createReader() const;
+
 		/**
 		 * @brief Fills command line template with given arguments. The returned list is ready for use for archiver process invocation. Special argument @@F is replaced with filename.
 		 *
@@ -93,7 +132,9 @@ namespace QComicBook
         void setFileMagic(const FileSignature &sig);
         void setExtractArguments(const QString &command);
         void setListArguments(const QString &command);
+        void setListPattern(const QString &pattern);
         void setSupported(bool f=true);
+        void setBuiltin(bool f=true);
         void setExecutables(const QString &exec1, const QString &exec2=QString::null);
         void addExtension(const QString &ext);
 
@@ -101,10 +142,12 @@ namespace QComicBook
         FileSignature signature;
         QString name;
         bool supported;
+        bool builtin;
         QStringList executables;
         QStringList extensions;
         QStringList extractArgs;
         QStringList listArgs;
+        QRegExp listPattern;
     };
 }
 
@@ -18,6 +18,12 @@
 #include "TargzArchiverStrategy.h"
 #include "Tarbz2ArchiverStrategy.h"
 #include "P7zipArchiverStrategy.h"
+#include "StoredZipArchiverStrategy.h"
+#include "TarArchiverStrategy.h"
+#include "GzipTarArchiverStrategy.h"
+#include "LibArchiveArchiverStrategy.h"
+#include "ArchiveReader.h"
+#include "FileTypeDetector.h"
 
 using namespace QComicBook;
 
@@ -35,6 +41,10 @@ ArchiversConfiguration::ArchiversConfiguration()
     archivers.append(new TargzArchiverStrategy());
     archivers.append(new Tarbz2ArchiverStrategy());
     archivers.append(new P7zipArchiverStrategy());
+    archivers.append(new StoredZipArchiverStrategy());
+    archivers.append(new TarArchiverStrategy());
+    archivers.append(new GzipTarArchiverStrategy());
+    archivers.append(new LibArchiveArchiverStrategy());
 
     foreach (ArchiverStrategy *s, archivers)
     {
@@ -52,26 +62,34 @@ ArchiversConfiguration::~ArchiversConfiguration()
 
 ArchiverStrategy* ArchiversConfiguration::findStrategy(const QString &filename) const
 {
-    QFile file(filename);
-    if (file.open(QIODevice::ReadOnly))
+    const QByteArray head(FileTypeDetector::readHead(filename));
+    if (head.isNull())
     {
-        foreach (ArchiverStrategy *s, archivers)
+        return NULL;
+    }
+    return findStrategy(filename, head);
+}
+
+ArchiverStrategy* ArchiversConfiguration::findStrategy(const QString &filename, const QByteArray &head) const
+{
+    foreach (ArchiverStrategy *s, archivers)
+    {
+        if (!s->isBuiltin() && s->canOpen(filename, head))
         {
-            if (s->canOpen(&file))
-            {
-                file.close();
-                return s;
-            }
+            return s;
         }
-        file.close();
-        foreach (ArchiverStrategy *s, archivers)
+    }
+    foreach (ArchiverStrategy *s, archivers)
+    {
+        if (s->isBuiltin())
         {
-            foreach (QString ext, s->getExtensions())
+            continue;
+        }
+        foreach (QString ext, s->getExtensions())
+        {
+            if (filename.endsWith(ext, Qt::CaseInsensitive))
             {
-                if (filename.endsWith(ext, Qt::CaseInsensitive))
-                {
-                    return s;
-                }
+                return s;
             }
         }
     }
@@ -80,7 +98,12 @@ ArchiverStrategy* ArchiversConfiguration::findStrategy(const QString &filename)
 
 void ArchiversConfiguration::getExtractArguments(const QString &filename, QStringList &extract, QStringList &list) const
 {
-    ArchiverStrategy *s = findStrategy(filename);
+    getExtractArguments(filename, FileTypeDetector::readHead(filename), extract, list);
+}
+
+void ArchiversConfiguration::getExtractArguments(const QString &filename, const QByteArray &head, QStringList &extract, QStringList &list) const
+{
+    ArchiverStrategy *s = head.isNull() ? NULL : findStrategy(filename, head);
     if (s)
     {
         extract = s->getExtractArguments(filename);
@@ -113,6 +136,85 @@ QStringList ArchiversConfiguration::getListArguments(const QString &filename) co
     return QStringList();
 }
 
+QRegExp ArchiversConfiguration::getListPattern(const QString &filename) const
+{
+    ArchiverStrategy *s = findStrategy(filename);
+    if (s)
+    {
+        return s->getListPattern();
+    }
+    return QRegExp();
+}
+
+QRegExp ArchiversConfiguration::getListPattern(const QString &filename, const QByteArray &head) const
+{
+    ArchiverStrategy *s = head.isNull() ? NULL : findStrategy(filename, head);
+    if (s)
+    {
+        return s->getListPattern();
+    }
+    return QRegExp();
+}
+
+ArchiveReader* ArchiversConfiguration::createReader(const QString &filename) const
+{
+    const QByteArray head(FileTypeDetector::readHead(filename));
+    return head.isNull() ? NULL : createReader(filename, head);
+}
+
+ArchiveReader* ArchiversConfiguration::createReader(const QString &filename, const QByteArray &head) const
+{
+    foreach (ArchiverStrategy *s, archivers)
+    {
+        if (s->isBuiltin() && s->canOpen(filename, head))
+        {
+            return s->createReader();
+        }
+    }
+    return NULL;
+}
+
+bool ArchiversConfiguration::isArchive(const QString &filename, const QByteArray &head) const
+{
+    foreach (ArchiverStrategy *s, archivers)
+    {
+        if (s->matchesSignature(head))
+        {
+            return true;
+        }
+    }
+    foreach (ArchiverStrategy *s, archivers)
+    {
+        foreach (const QString ext, s->getExtensions())
+        {
+            if (filename.endsWith(ext, Qt::CaseInsensitive))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+ArchiveReader* ArchiversConfiguration::openReader(const QByteArray &data) const
+{
+    //
+    // there is no file to check signatures of; let builtin readers try in turn
+    foreach (ArchiverStrategy *s, archivers)
+    {
+        if (s->isBuiltin() && s->isSupported())
+        {
+            ArchiveReader *r = s->createReader();
+            if (r && r->openData(data))
+            {
+                return r;
+            }
+            delete r;
+        }
+    }
+    return NULL;
+}
+
 QStringList ArchiversConfiguration::supportedOpenExtensions() const
 {
     QStringList extlist;
@@ -120,7 +222,10 @@ QStringList ArchiversConfiguration::supportedOpenExtensions() const
     {
         foreach (const QString ext, s->getExtensions())
         {
-            extlist.append("*" + ext);
+            if (!extlist.contains("*" + ext))
+            {
+                extlist.append("*" + ext);
+            }
         }
     }
     return extlist;
@@ -145,7 +250,7 @@ QList<ArchiverHint> ArchiversConfiguration::getHints() const
     foreach (ArchiverStrategy *s, archivers)
     {
         hints.append(s->getHints());
-        all_supported = all_supported && s->isSupported();
+        all_supported = all_supported && (s->isSupported() || s->isBuiltin());
     }
     if (!all_supported)
     {
@@ -16,11 +16,14 @@
 #include <QObject>
 #include <QList>
 #include <QStringList>
+#include <QRegExp>
+#include <QByteArray>
 #include "ArchiverStatus.h"
 
 namespace QComicBook
 {
     class ArchiverStrategy;
+    class ArchiveReader;
 
     class ArchiversConfiguration: public QObject
     {
@@ -29,8 +32,17 @@ namespace QComicBook
     public:
         static ArchiversConfiguration& instance();
         void getExtractArguments(const QString &filename, QStringList &extract, QStringList &list) const;
+        //! Same as above, for file which head was already read with FileTypeDetector::readHead().
+        void getExtractArguments(const QString &filename, const QByteArray &head, QStringList &extract, QStringList &list) const;
         QStringList getExtractArguments(const QString &filename) const;
         QStringList getListArguments(const QString &filename) const;
+        QRegExp getListPattern(const QString &filename) const;
+        QRegExp getListPattern(const QString &filename, const QByteArray &head) const;
+        ArchiveReader* createReader(const QString &filename) const;
+        ArchiveReader* createReader(const QString &filename, const QByteArray &head) const;
+        //! Returns true if head of the file matches signature of any archiver or file has archive extension.
+        bool isArchive(const QString &filename, const QByteArray &head) const;
+        ArchiveReader* openReader(const QByteArray &data) const;
         QStringList supportedOpenExtensions() const;
         QList<ArchiverStatus> getArchiversStatus() const;
         QList<ArchiverHint> getHints() const;
@@ -39,6 +51,7 @@ namespace QComicBook
         ArchiversConfiguration();
         ~ArchiversConfiguration();
         ArchiverStrategy* findStrategy(const QString &filename) const;
+        ArchiverStrategy* findStrategy(const QString &filename, const QByteArray &head) const;
 
         QList<ArchiverStrategy *> archivers;
     };
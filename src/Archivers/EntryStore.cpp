@@ -0,0 +1,125 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "EntryStore.h"
+#include <QMutexLocker>
+
+using namespace QComicBook;
+
+EntryStore::EntryStore(qint64 maxBytes)
+    : bytes(0)
+    , maxBytes(maxBytes)
+    , next(0)
+    , waiting(0)
+    , finished(false)
+    , stopped(false)
+{
+}
+
+EntryStore::~EntryStore()
+{
+}
+
+void EntryStore::dropOne()
+{
+    int victim = order.first();
+    foreach (int e, order)
+    {
+        if (consumed.contains(e))
+        {
+            victim = e;
+            break;
+        }
+    }
+    order.removeOne(victim);
+    consumed.remove(victim);
+    bytes -= entries.take(victim).size();
+}
+
+bool EntryStore::put(int entry, const QByteArray &data)
+{
+    QMutexLocker lock(&mtx);
+    while (!stopped && !order.isEmpty() && bytes + data.size() > maxBytes)
+    {
+        //
+        // keep entries nobody has read yet, unless someone waits for more
+        if (waiting > 0 || !consumed.isEmpty())
+        {
+            dropOne();
+        }
+        else
+        {
+            spaceCond.wait(&mtx);
+        }
+    }
+    if (stopped)
+    {
+        return false;
+    }
+    entries.insert(entry, data);
+    order.append(entry);
+    bytes += data.size();
+    next = entry + 1;
+    dataCond.wakeAll();
+    return true;
+}
+
+void EntryStore::finish()
+{
+    QMutexLocker lock(&mtx);
+    finished = true;
+    dataCond.wakeAll();
+}
+
+bool EntryStore::get(int entry, QByteArray &data)
+{
+    QMutexLocker lock(&mtx);
+    for (;;)
+    {
+        QMap<int, QByteArray>::const_iterator it = entries.constFind(entry);
+        if (it != entries.constEnd())
+        {
+            data = it.value();
+            consumed.insert(entry);
+            spaceCond.wakeAll();
+            return true;
+        }
+        if (stopped || finished || entry < next)
+        {
+            return false;
+        }
+        ++waiting;
+        spaceCond.wakeAll();
+        dataCond.wait(&mtx);
+        --waiting;
+    }
+}
+
+void EntryStore::stop()
+{
+    QMutexLocker lock(&mtx);
+    stopped = true;
+    dataCond.wakeAll();
+    spaceCond.wakeAll();
+}
+
+qint64 EntryStore::size() const
+{
+    QMutexLocker lock(&mtx);
+    return bytes;
+}
+
+int EntryStore::count() const
+{
+    QMutexLocker lock(&mtx);
+    return entries.size();
+}
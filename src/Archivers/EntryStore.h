@@ -0,0 +1,87 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __ENTRY_STORE_H
+#define __ENTRY_STORE_H
+
+#include <QMap>
+#include <QList>
+#include <QSet>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace QComicBook
+{
+	/**
+	 * @brief Bounded store of archive entries filled by a single producer in archive order.
+	 *
+	 * The producer (e.g. decoder of solid archive) put()s entries in increasing order and blocks
+	 * when the store is full. Consumers get() entries, waiting for ones the producer hasn't reached yet.
+	 * When the store is full, entries that were already consumed are dropped first; unconsumed ones
+	 * are dropped only when some consumer waits for an entry further in the archive.
+	 */
+    class EntryStore
+    {
+    public:
+        EntryStore(qint64 maxBytes);
+        ~EntryStore();
+
+		/**
+		 * @brief Stores data of the entry; called by the producer. Blocks while the store is full.
+		 *
+		 * @return false if store was stopped and producer should quit
+		 */
+        bool put(int entry, const QByteArray &data);
+
+		/**
+		 * @brief Marks the end of data; called by the producer when it is done or failed.
+		 */
+        void finish();
+
+		/**
+		 * @brief Returns data of the entry, waiting for the producer if needed.
+		 *
+		 * @param entry entry index
+		 * @param data receives entry data
+		 *
+		 * @return false if entry was dropped already or won't be produced
+		 */
+        bool get(int entry, QByteArray &data);
+
+		/**
+		 * @brief Wakes up producer and all consumers; no more entries are accepted.
+		 */
+        void stop();
+
+        qint64 size() const;
+        int count() const;
+
+    private:
+        void dropOne();
+
+        mutable QMutex mtx;
+        QWaitCondition dataCond; //!< signaled when new entry is stored
+        QWaitCondition spaceCond; //!< signaled when producer may make progress
+        QMap<int, QByteArray> entries;
+        QList<int> order; //!< stored entries, oldest first
+        QSet<int> consumed; //!< entries returned by get() at least once
+        qint64 bytes; //!< total size of stored entries
+        qint64 maxBytes;
+        int next; //!< next entry expected from the producer
+        int waiting; //!< number of consumers waiting for the producer
+        bool finished;
+        bool stopped;
+    };
+}
+
+#endif
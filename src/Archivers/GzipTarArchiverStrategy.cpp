@@ -0,0 +1,44 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "config.h"
+#include "GzipTarArchiverStrategy.h"
+#include "GzipTarReader.h"
+
+using namespace QComicBook;
+
+GzipTarArchiverStrategy::GzipTarArchiverStrategy()
+    : ArchiverStrategy("tar.gz (indexed)", FileSignature(0, "\x1f\x8b", 2))
+{
+}
+
+GzipTarArchiverStrategy::~GzipTarArchiverStrategy()
+{
+}
+
+void GzipTarArchiverStrategy::configure()
+{
+    addExtension(".tar.gz");
+    addExtension(".tgz");
+    addExtension(".cbg");
+    setExecutables("zlib");
+    setBuiltin();
+
+#ifdef HAVE_ZLIB
+    setSupported();
+#endif
+}
+
+ArchiveReader* GzipTarArchiverStrategy::createReader() const
+{
+    return new GzipTarReader();
+}
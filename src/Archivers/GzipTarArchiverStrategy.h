@@ -0,0 +1,31 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __GZIP_TAR_ARCHIVER_STRATEGY_H
+#define __GZIP_TAR_ARCHIVER_STRATEGY_H
+
+#include "ArchiverStrategy.h"
+
+namespace QComicBook
+{
+    class GzipTarArchiverStrategy: public ArchiverStrategy
+    {
+    public:
+        GzipTarArchiverStrategy();
+        virtual ~GzipTarArchiverStrategy();
+
+        virtual void configure();
+        virtual ArchiveReader* createReader() const;
+    };
+}
+
+#endif
@@ -0,0 +1,397 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "config.h"
+#include "GzipTarReader.h"
+#include <QDataStream>
+#include "ComicBookDebug.h"
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace QComicBook;
+
+const qint64 GzipTarReader::SPAN = 2*1024*1024;
+const int GzipTarReader::WINSIZE = 32768;
+const int GzipTarReader::CHUNK = 16384;
+
+GzipTarReader::GzipTarReader(): TarReader()
+{
+}
+
+GzipTarReader::~GzipTarReader()
+{
+    close();
+}
+
+QString GzipTarReader::name() const
+{
+    return "tar.gz";
+}
+
+void GzipTarReader::close()
+{
+    points.clear();
+    TarReader::close();
+}
+
+TarReader::HeaderType GzipTarReader::scan(ScanState &st, const char *data, int len)
+{
+    const qint64 pos = st.pos;
+    st.pos += len;
+    if (st.buf.isEmpty())
+    {
+        //
+        // skip member data up to the next header
+        if (pos + len <= st.next)
+        {
+            return OTHER;
+        }
+        const qint64 skip = qMax(static_cast<qint64>(0), st.next - pos);
+        st.buf.append(data + skip, len - skip);
+    }
+    else
+    {
+        st.buf.append(data, len);
+    }
+
+    while (st.buf.size() >= BLOCK_SIZE)
+    {
+        const char *header = st.buf.constData();
+        qint64 size;
+        const HeaderType type = headerType(header, size);
+        if (type == END || type == INVALID)
+        {
+            return type;
+        }
+        if (type == LONGNAME)
+        {
+            //
+            // headerType() limits long names to MAX_LONGNAME, so at most that much is buffered
+            if (size > MAX_LONGNAME)
+            {
+                return INVALID;
+            }
+            if (st.buf.size() < BLOCK_SIZE + size)
+            {
+                break; // wait for the rest of long name
+            }
+            st.longname = longName(header, st.buf.mid(BLOCK_SIZE, size));
+        }
+        else
+        {
+            if (type == MEMBER)
+            {
+                addEntry(header, st.next, st.index, st.longname);
+            }
+            st.longname.clear();
+        }
+        ++st.index;
+
+        const qint64 advance = BLOCK_SIZE + paddedSize(size);
+        st.next += advance;
+        if (advance >= st.buf.size())
+        {
+            st.buf.clear();
+        }
+        else
+        {
+            st.buf.remove(0, advance);
+        }
+    }
+    return OTHER;
+}
+
+bool GzipTarReader::openData(const QByteArray &)
+{
+    //
+    // seek points are only worth it for big files; in-memory archives are left to libarchive
+    return false;
+}
+
+QByteArray GzipTarReader::indexData() const
+{
+    QByteArray data;
+    QDataStream str(&data, QIODevice::WriteOnly);
+    str.setVersion(QDataStream::Qt_5_0);
+    str << static_cast<qint32>(points.size());
+    foreach (const SeekPoint &p, points)
+    {
+        str << p.out << p.in << static_cast<qint32>(p.bits) << qCompress(p.window);
+    }
+    return data;
+}
+
+bool GzipTarReader::reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data)
+{
+    if (!TarReader::reopen(filename, entries, data))
+    {
+        return false;
+    }
+
+    QDataStream str(data);
+    str.setVersion(QDataStream::Qt_5_0);
+    qint32 n = 0;
+    str >> n;
+    for (int i=0; i<n && str.status() == QDataStream::Ok; i++)
+    {
+        SeekPoint p;
+        qint32 bits;
+        QByteArray window;
+        str >> p.out >> p.in >> bits >> window;
+        p.bits = bits;
+        p.window = qUncompress(window);
+        if (p.window.size() != WINSIZE)
+        {
+            break;
+        }
+        points.append(p);
+    }
+    if (str.status() != QDataStream::Ok || points.isEmpty() || points.size() != n)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void GzipTarReader::addPoint(int bits, qint64 in, qint64 out, int left, const unsigned char *window)
+{
+    SeekPoint p;
+    p.out = out;
+    p.in = in;
+    p.bits = bits;
+
+    //
+    // window is circular; left is the number of bytes not yet written at its end
+    p.window.resize(WINSIZE);
+    char *w = p.window.data();
+    if (left)
+    {
+        memcpy(w, window + WINSIZE - left, left);
+    }
+    if (left < WINSIZE)
+    {
+        memcpy(w + left, window, WINSIZE - left);
+    }
+    points.append(p);
+}
+
+#ifdef HAVE_ZLIB
+
+bool GzipTarReader::open(const QString &filename)
+{
+    close();
+    if (!openFile(filename))
+    {
+        return false;
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, 47) != Z_OK) // gzip or zlib header
+    {
+        TarReader::close();
+        return false;
+    }
+
+    unsigned char input[CHUNK];
+    unsigned char window[WINSIZE];
+    qint64 totin = 0, totout = 0, last = 0;
+    ScanState st;
+    HeaderType scanned = OTHER;
+    int ret = Z_OK;
+    bool ok = true;
+
+    strm.avail_out = 0;
+    while (ok && ret != Z_STREAM_END && scanned != END)
+    {
+        const ssize_t n = ::read(fd, input, CHUNK);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            ok = false; // truncated archive
+            break;
+        }
+        strm.avail_in = n;
+        strm.next_in = input;
+        do
+        {
+            if (strm.avail_out == 0)
+            {
+                strm.avail_out = WINSIZE;
+                strm.next_out = window;
+            }
+            unsigned char *outstart = strm.next_out;
+            totin += strm.avail_in;
+            totout += strm.avail_out;
+            ret = inflate(&strm, Z_BLOCK); // return at end of every deflate block
+            totin -= strm.avail_in;
+            totout -= strm.avail_out;
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR)
+            {
+                _DEBUG << "inflate error" << ret << filename;
+                ok = false;
+                break;
+            }
+
+            scanned = scan(st, reinterpret_cast<const char *>(outstart), strm.next_out - outstart);
+            if (scanned == INVALID)
+            {
+                _DEBUG << "bad tar header at" << st.next;
+                ok = false;
+                break;
+            }
+            if (scanned == END || ret == Z_STREAM_END)
+            {
+                break;
+            }
+
+            //
+            // block boundary that is not the end of the stream
+            if ((strm.data_type & 128) && !(strm.data_type & 64) && (totout == 0 || totout - last > SPAN))
+            {
+                addPoint(strm.data_type & 7, totin, totout, strm.avail_out, window);
+                last = totout;
+            }
+        } while (strm.avail_in != 0);
+    }
+    inflateEnd(&strm);
+
+    if (!ok || points.isEmpty())
+    {
+        close();
+        return false;
+    }
+    _DEBUG << m_entries.size() << "entries," << points.size() << "seek points in" << filename;
+    m_filename = filename;
+    return true;
+}
+
+bool GzipTarReader::readData(qint64 offset, char *buf, qint64 len) const
+{
+    //
+    // avail_out is 32-bit; callers never read more than a QByteArray holds
+    if (offset < 0 || len < 0 || len > INT_MAX)
+    {
+        return false;
+    }
+
+    //
+    // find the last seek point before offset
+    int i = points.size() - 1;
+    while (i > 0 && points.at(i).out > offset)
+    {
+        --i;
+    }
+    if (i < 0 || points.at(i).out > offset)
+    {
+        return false;
+    }
+    const SeekPoint &p(points.at(i));
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, -15) != Z_OK) // raw deflate
+    {
+        return false;
+    }
+
+    qint64 inpos = p.in;
+    if (p.bits)
+    {
+        unsigned char c;
+        if (pread(fd, &c, 1, inpos - 1) != 1)
+        {
+            inflateEnd(&strm);
+            return false;
+        }
+        inflatePrime(&strm, p.bits, c >> (8 - p.bits));
+    }
+    inflateSetDictionary(&strm, reinterpret_cast<const Bytef *>(p.window.constData()), WINSIZE);
+
+    unsigned char input[CHUNK];
+    unsigned char discard[WINSIZE];
+    qint64 skip = offset - p.out;
+    qint64 done = 0;
+    while (done < len)
+    {
+        if (strm.avail_in == 0)
+        {
+            const ssize_t n = pread(fd, input, CHUNK, inpos);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            inpos += n;
+            strm.avail_in = n;
+            strm.next_in = input;
+        }
+        if (skip > 0)
+        {
+            strm.next_out = discard;
+            strm.avail_out = qMin(skip, static_cast<qint64>(WINSIZE));
+        }
+        else
+        {
+            strm.next_out = reinterpret_cast<unsigned char *>(buf + done);
+            strm.avail_out = len - done;
+        }
+        const uInt before = strm.avail_out;
+        const int ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR)
+        {
+            break;
+        }
+        const qint64 produced = before - strm.avail_out;
+        if (skip > 0)
+        {
+            skip -= produced;
+        }
+        else
+        {
+            done += produced;
+        }
+        if (ret == Z_STREAM_END)
+        {
+            break;
+        }
+    }
+    inflateEnd(&strm);
+    return done == len;
+}
+
+#else
+
+bool GzipTarReader::open(const QString &)
+{
+    return false;
+}
+
+bool GzipTarReader::readData(qint64, char *, qint64) const
+{
+    return false;
+}
+
+#endif
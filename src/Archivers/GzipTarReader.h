@@ -0,0 +1,78 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __GZIP_TAR_READER_H
+#define __GZIP_TAR_READER_H
+
+#include "TarReader.h"
+#include <QList>
+#include <QByteArray>
+
+namespace QComicBook
+{
+	/**
+	 * @brief Random-access reader of gzip-compressed tar archives.
+	 *
+	 * The whole stream is decompressed once on open to find tar headers; at the same time
+	 * seek points (deflate block boundary and preceding 32KB of output) are recorded every
+	 * SPAN bytes, like in zran.c from zlib examples. A member is then read by decompressing
+	 * from the nearest preceding seek point. Seek points are kept in the book index.
+	 */
+    class GzipTarReader: public TarReader
+    {
+    public:
+        GzipTarReader();
+        virtual ~GzipTarReader();
+
+        virtual bool open(const QString &filename);
+        virtual bool openData(const QByteArray &data);
+        virtual bool reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data);
+        virtual void close();
+        virtual QByteArray indexData() const;
+        virtual QString name() const;
+
+    protected:
+        virtual bool readData(qint64 offset, char *buf, qint64 len) const;
+
+    private:
+        struct SeekPoint
+        {
+            qint64 out; //!< offset in uncompressed data
+            qint64 in; //!< offset in compressed file of the first full byte
+            int bits; //!< number of bits of the preceding byte that belong to the block
+            QByteArray window; //!< preceding 32KB of uncompressed data
+        };
+
+        //! State of the tar header scan over decompressed stream.
+        struct ScanState
+        {
+            qint64 pos; //!< offset of the data passed next to scan()
+            qint64 next; //!< offset of the next tar header
+            int index; //!< number of the next header
+            QByteArray buf; //!< data starting at next
+            QByteArray longname;
+
+            ScanState(): pos(0), next(0), index(0) {}
+        };
+
+        HeaderType scan(ScanState &st, const char *data, int len);
+        void addPoint(int bits, qint64 in, qint64 out, int left, const unsigned char *window);
+
+        static const qint64 SPAN;
+        static const int WINSIZE;
+        static const int CHUNK;
+
+        QList<SeekPoint> points;
+    };
+}
+
+#endif
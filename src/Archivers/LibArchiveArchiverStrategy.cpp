@@ -0,0 +1,77 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "config.h"
+#include "LibArchiveArchiverStrategy.h"
+#include "LibArchiveReader.h"
+#include "ArchiversConfiguration.h"
+#include <QFile>
+
+using namespace QComicBook;
+
+LibArchiveArchiverStrategy::LibArchiveArchiverStrategy()
+    : ArchiverStrategy("libarchive", FileSignature())
+{
+}
+
+LibArchiveArchiverStrategy::~LibArchiveArchiverStrategy()
+{
+}
+
+void LibArchiveArchiverStrategy::configure()
+{
+    addExtension(".zip");
+    addExtension(".cbz");
+    addExtension(".rar");
+    addExtension(".cbr");
+    addExtension(".7z");
+    addExtension(".cb7");
+    addExtension(".tar");
+    addExtension(".cbt");
+    addExtension(".tar.gz");
+    addExtension(".tgz");
+    addExtension(".cbg");
+    addExtension(".tar.bz2");
+    addExtension(".cbb");
+    setExecutables("libarchive");
+    setBuiltin();
+
+#ifdef HAVE_LIBARCHIVE
+    setSupported();
+#endif
+}
+
+bool LibArchiveArchiverStrategy::canOpen(const QString &filename, const QByteArray &head) const
+{
+    //
+    // libarchive does its own format detection
+    return isSupported() && LibArchiveReader::canRead(filename);
+}
+
+ArchiveReader* LibArchiveArchiverStrategy::createReader() const
+{
+    return new LibArchiveReader();
+}
+
+QList<ArchiverHint> LibArchiveArchiverStrategy::getHints() const
+{
+    QList<ArchiverHint> hints;
+    if (!isSupported())
+    {
+        hints.append(ArchiverHint(
+                         ArchiversConfiguration::tr("QComicBook was built without libarchive support. "
+                                                    "Archives are unpacked to temporary directory with external archivers, "
+                                                    "which is much slower for big archives."),
+                         ArchiverHint::Info));
+    }
+    return hints;
+}
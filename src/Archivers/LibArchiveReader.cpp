@@ -0,0 +1,470 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "config.h"
+#include "LibArchiveReader.h"
+#include "EntryStore.h"
+#include <QFile>
+#include <QMap>
+#include <QThread>
+#include <QMutexLocker>
+#include "ComicBookDebug.h"
+
+#ifdef HAVE_LIBARCHIVE
+#include <archive.h>
+#include <archive_entry.h>
+#endif
+
+using namespace QComicBook;
+
+const int LibArchiveReader::BLOCK_SIZE = 65536;
+const qint64 LibArchiveReader::SOLID_STORE_SIZE = 64*1024*1024;
+
+//
+// runs LibArchiveReader::decodeAll()
+class LibArchiveReader::DecoderThread: public QThread
+{
+public:
+    DecoderThread(LibArchiveReader *r): QThread(), reader(r) {}
+
+protected:
+    virtual void run()
+    {
+        reader->decodeAll();
+    }
+
+private:
+    LibArchiveReader *reader;
+};
+
+LibArchiveReader::LibArchiveReader(): ArchiveReader(), m_solid(false), m_store(NULL), m_decoder(NULL)
+{
+}
+
+LibArchiveReader::~LibArchiveReader()
+{
+    close();
+}
+
+QString LibArchiveReader::name() const
+{
+    return "libarchive";
+}
+
+QByteArray LibArchiveReader::indexData() const
+{
+    return m_solid ? QByteArray("solid") : QByteArray();
+}
+
+bool LibArchiveReader::reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data)
+{
+    if (!ArchiveReader::reopen(filename, entries, data))
+    {
+        return false;
+    }
+    m_solid = (data == "solid");
+    return true;
+}
+
+void LibArchiveReader::stopDecoder()
+{
+    QMutexLocker lock(&m_decodermtx);
+    if (m_decoder)
+    {
+        m_store->stop();
+        m_decoder->wait();
+        delete m_decoder;
+        m_decoder = NULL;
+    }
+    delete m_store;
+    m_store = NULL;
+}
+
+void LibArchiveReader::close()
+{
+    stopDecoder();
+    m_solid = false;
+    m_data.clear();
+    ArchiveReader::close();
+}
+
+QByteArray LibArchiveReader::read(int entry)
+{
+    if (entry < 0 || entry >= m_entries.size())
+    {
+        return QByteArray();
+    }
+    if (m_solid)
+    {
+        m_decodermtx.lock();
+        if (!m_decoder)
+        {
+            m_store = new EntryStore(SOLID_STORE_SIZE);
+            m_decoder = new DecoderThread(this);
+            m_decoder->start(QThread::LowPriority);
+        }
+        EntryStore *store = m_store;
+        m_decodermtx.unlock();
+
+        QByteArray data;
+        if (store->get(entry, data))
+        {
+            return data;
+        }
+        _DEBUG << "entry" << entry << "not in decoded store";
+    }
+    return readDirect(entry);
+}
+
+QList<QByteArray> LibArchiveReader::readEntries(const QList<int> &entries)
+{
+    //
+    // solid archives are served from the decoder's store
+    if (m_solid || entries.size() < 2)
+    {
+        return ArchiveReader::readEntries(entries);
+    }
+    return readDirect(entries);
+}
+
+#ifdef HAVE_LIBARCHIVE
+
+struct archive* LibArchiveReader::openArchive(const QString &filename, const QByteArray &data)
+{
+    struct archive *a = archive_read_new();
+    archive_read_support_filter_all(a);
+    archive_read_support_format_zip(a);
+    archive_read_support_format_rar(a);
+#if ARCHIVE_VERSION_NUMBER >= 3004000
+    archive_read_support_format_rar5(a);
+#endif
+    archive_read_support_format_7zip(a);
+    archive_read_support_format_tar(a);
+
+    const int status = data.isEmpty()
+        ? archive_read_open_filename(a, QFile::encodeName(filename).constData(), BLOCK_SIZE)
+        : archive_read_open_memory(a, const_cast<char *>(data.constData()), data.size());
+    if (status != ARCHIVE_OK)
+    {
+        _DEBUG << "libarchive can't open" << filename << archive_error_string(a);
+        archive_read_free(a);
+        return NULL;
+    }
+    return a;
+}
+
+QByteArray LibArchiveReader::readData(struct archive *a, qint64 sizeHint)
+{
+    QByteArray data;
+    if (sizeHint > 0)
+    {
+        data.reserve(sizeHint);
+    }
+    char buf[BLOCK_SIZE];
+    for (;;)
+    {
+        const ssize_t n = archive_read_data(a, buf, sizeof(buf));
+        if (n < 0)
+        {
+            _DEBUG << "read error" << archive_error_string(a);
+            return QByteArray();
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        data.append(buf, n);
+    }
+    return data;
+}
+
+bool LibArchiveReader::canRead(const QString &filename)
+{
+    struct archive *a = openArchive(filename, QByteArray());
+    if (a)
+    {
+        struct archive_entry *e;
+        const bool ok = (archive_read_next_header(a, &e) == ARCHIVE_OK);
+        archive_read_free(a);
+        return ok;
+    }
+    return false;
+}
+
+bool LibArchiveReader::open(const QString &filename)
+{
+    close();
+
+    QFile f(filename);
+    if (!f.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    const QByteArray head(f.read(64));
+    f.close();
+
+    if (!readHeaders(openArchive(filename, QByteArray()), head))
+    {
+        close();
+        return false;
+    }
+    m_filename = filename;
+    _DEBUG << filename << (m_solid ? "is solid" : "is not solid");
+    return true;
+}
+
+bool LibArchiveReader::openData(const QByteArray &data)
+{
+    close();
+    if (data.isEmpty() || !readHeaders(openArchive(QString(), data), data.left(64)))
+    {
+        close();
+        return false;
+    }
+    m_data = data;
+    return true;
+}
+
+bool LibArchiveReader::readHeaders(struct archive *a, const QByteArray &head)
+{
+    if (!a)
+    {
+        return false;
+    }
+
+    struct archive_entry *e;
+    int status;
+    for (int i=0; (status = archive_read_next_header(a, &e)) == ARCHIVE_OK; i++)
+    {
+        if (archive_entry_filetype(e) == AE_IFREG)
+        {
+            ArchiveEntry entry;
+            entry.name = QFile::decodeName(archive_entry_pathname(e));
+            entry.index = i;
+            entry.offset = archive_read_header_position(a);
+            if (archive_entry_size_is_set(e))
+            {
+                entry.size = archive_entry_size(e);
+            }
+            m_entries.append(entry);
+        }
+        archive_read_data_skip(a);
+    }
+    const int format = archive_format(a) & ARCHIVE_FORMAT_BASE_MASK;
+    archive_read_free(a);
+
+    if (status != ARCHIVE_EOF)
+    {
+        return false;
+    }
+    m_solid = isSolid(head, format);
+    return true;
+}
+
+QList<QByteArray> LibArchiveReader::readDirect(const QList<int> &entries)
+{
+    QList<QByteArray> data;
+    QMap<int, int> wanted; // header number -> position in entries
+    for (int i=0; i<entries.size(); i++)
+    {
+        data.append(QByteArray());
+        if (entries.at(i) >= 0 && entries.at(i) < m_entries.size())
+        {
+            wanted.insert(m_entries.at(entries.at(i)).index, i);
+        }
+    }
+    if (wanted.isEmpty())
+    {
+        return data;
+    }
+
+    struct archive *a = openArchive(m_filename, m_data);
+    if (!a)
+    {
+        return data;
+    }
+
+    //
+    // single walk over the headers serves all entries; stops after the last one
+    const int last = (wanted.end() - 1).key();
+    struct archive_entry *e;
+    for (int i=0; i <= last && archive_read_next_header(a, &e) == ARCHIVE_OK; i++)
+    {
+        const QMap<int, int>::const_iterator it = wanted.constFind(i);
+        if (it == wanted.constEnd())
+        {
+            archive_read_data_skip(a);
+            continue;
+        }
+        data[it.value()] = readData(a, m_entries.at(entries.at(it.value())).size);
+        //
+        // the same entry may be requested more than once
+        for (int k=0; k<entries.size(); k++)
+        {
+            if (k != it.value() && entries.at(k) == entries.at(it.value()))
+            {
+                data[k] = data.at(it.value());
+            }
+        }
+    }
+    archive_read_free(a);
+    return data;
+}
+
+QByteArray LibArchiveReader::readDirect(int entry)
+{
+    const ArchiveEntry &ae(m_entries.at(entry));
+
+    struct archive *a = openArchive(m_filename, m_data);
+    if (!a)
+    {
+        return QByteArray();
+    }
+
+    //
+    // libarchive is stream-oriented: walk the headers up to requested one;
+    // skipping is a seek for seekable formats (zip, plain tar).
+    QByteArray data;
+    struct archive_entry *e;
+    for (int i=0; archive_read_next_header(a, &e) == ARCHIVE_OK; i++)
+    {
+        if (i == ae.index)
+        {
+            data = readData(a, ae.size);
+            break;
+        }
+        archive_read_data_skip(a);
+    }
+    archive_read_free(a);
+    return data;
+}
+
+void LibArchiveReader::decodeAll()
+{
+    struct archive *a = openArchive(m_filename, m_data);
+    if (a)
+    {
+        //
+        // entries list holds regular files only; match them by header number
+        struct archive_entry *e;
+        int k = 0;
+        for (int i=0; k < m_entries.size() && archive_read_next_header(a, &e) == ARCHIVE_OK; i++)
+        {
+            if (m_entries.at(k).index != i)
+            {
+                archive_read_data_skip(a);
+                continue;
+            }
+            if (!m_store->put(k, readData(a, m_entries.at(k).size)))
+            {
+                break; // stopped
+            }
+            ++k;
+        }
+        _DEBUG << "decoded" << k << "entries of" << m_filename;
+        archive_read_free(a);
+    }
+    m_store->finish();
+}
+
+bool LibArchiveReader::isSolid(const QByteArray &head, int format)
+{
+    if (format == ARCHIVE_FORMAT_7ZIP)
+    {
+        return true; // solid is the default for 7z and the flag is hidden in compressed headers
+    }
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(head.constData());
+
+    if (format == ARCHIVE_FORMAT_RAR && head.size() >= 12 && head.startsWith(QByteArray("Rar!\x1a\x07\x00", 7)))
+    {
+        //
+        // main header follows the marker: crc(2), type(1), flags(2)
+        return p[9] == 0x73 && ((p[10] | (p[11] << 8)) & 0x0008);
+    }
+#ifdef ARCHIVE_FORMAT_RAR_V5
+    if (format == ARCHIVE_FORMAT_RAR_V5 && head.startsWith(QByteArray("Rar!\x1a\x07\x01\x00", 8)))
+    {
+        //
+        // main archive header: crc32, then vints: size, type, flags, [extra size], [data size], archive flags
+        int pos = 12;
+        quint64 v[6];
+        for (int n=0; n<6; n++)
+        {
+            v[n] = 0;
+            for (int shift=0; pos < head.size(); shift += 7)
+            {
+                const unsigned char c = p[pos++];
+                v[n] |= static_cast<quint64>(c & 0x7f) << shift;
+                if (!(c & 0x80))
+                {
+                    break;
+                }
+            }
+        }
+        if (v[1] != 1)
+        {
+            return false; // e.g. encrypted headers
+        }
+        int flagsIdx = 3;
+        if (v[2] & 0x0001)
+        {
+            ++flagsIdx;
+        }
+        if (v[2] & 0x0002)
+        {
+            ++flagsIdx;
+        }
+        return v[flagsIdx] & 0x0004;
+    }
+#endif
+    return false;
+}
+
+#else
+
+bool LibArchiveReader::canRead(const QString &)
+{
+    return false;
+}
+
+bool LibArchiveReader::open(const QString &)
+{
+    return false;
+}
+
+bool LibArchiveReader::openData(const QByteArray &)
+{
+    return false;
+}
+
+QByteArray LibArchiveReader::readDirect(int)
+{
+    return QByteArray();
+}
+
+QList<QByteArray> LibArchiveReader::readDirect(const QList<int> &entries)
+{
+    QList<QByteArray> data;
+    for (int i=0; i<entries.size(); i++)
+    {
+        data.append(QByteArray());
+    }
+    return data;
+}
+
+void LibArchiveReader::decodeAll()
+{
+    m_store->finish();
+}
+
+#endif
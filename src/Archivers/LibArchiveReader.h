@@ -0,0 +1,76 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __LIBARCHIVE_READER_H
+#define __LIBARCHIVE_READER_H
+
+#include "ArchiveReader.h"
+#include <QMutex>
+
+struct archive;
+
+namespace QComicBook
+{
+    class EntryStore;
+
+	/**
+	 * @brief Archive reader based on libarchive; handles zip, rar, 7z and (compressed) tar archives.
+	 *
+	 * Every read() call uses its own libarchive handle, so reads from many threads don't block each other.
+	 * Solid archives are an exception: any entry can only be reached by decompressing all preceding ones,
+	 * so a background thread decodes them once in archive order into an EntryStore which read() takes
+	 * entries from.
+	 */
+    class LibArchiveReader: public ArchiveReader
+    {
+    public:
+        LibArchiveReader();
+        virtual ~LibArchiveReader();
+
+        virtual bool open(const QString &filename);
+        virtual bool openData(const QByteArray &data);
+        virtual bool reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data);
+        virtual void close();
+        virtual QByteArray read(int entry);
+        virtual QList<QByteArray> readEntries(const QList<int> &entries);
+        virtual QByteArray indexData() const;
+        virtual QString name() const;
+
+		/**
+		 * @brief Return true if libarchive recognizes format of given file.
+		 */
+        static bool canRead(const QString &filename);
+
+    private:
+        class DecoderThread;
+
+        static struct archive* openArchive(const QString &filename, const QByteArray &data);
+        static QByteArray readData(struct archive *a, qint64 sizeHint);
+        static bool isSolid(const QByteArray &head, int format);
+        bool readHeaders(struct archive *a, const QByteArray &head);
+        QByteArray readDirect(int entry);
+        QList<QByteArray> readDirect(const QList<int> &entries);
+        void decodeAll();
+        void stopDecoder();
+
+        static const int BLOCK_SIZE;
+        static const qint64 SOLID_STORE_SIZE;
+
+        QByteArray m_data; //!< archive contents if opened with openData()
+        bool m_solid; //!< true if entries can't be read independently
+        EntryStore *m_store; //!< entries decoded by m_decoder
+        DecoderThread *m_decoder; //!< background decoder of solid archive; started on first read
+        QMutex m_decodermtx;
+    };
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "MountCache.h"
+#include "ArchiveReader.h"
+#include <QMutexLocker>
+
+using namespace QComicBook;
+
+const qint64 MountCache::DEFAULT_SIZE = 256*1024*1024;
+
+MountCache& MountCache::instance()
+{
+    static MountCache cache;
+    return cache;
+}
+
+MountCache::MountCache()
+{
+    setMaxSize(DEFAULT_SIZE);
+}
+
+MountCache::~MountCache()
+{
+}
+
+QSharedPointer<ArchiveReader> MountCache::get(const QString &key)
+{
+    QMutexLocker lock(&mtx);
+    QSharedPointer<ArchiveReader> *r = cache.object(key);
+    return r ? *r : QSharedPointer<ArchiveReader>();
+}
+
+void MountCache::insert(const QString &key, const QSharedPointer<ArchiveReader> &reader, qint64 size)
+{
+    QMutexLocker lock(&mtx);
+    cache.insert(key, new QSharedPointer<ArchiveReader>(reader), static_cast<int>(size / 1024) + 1);
+}
+
+void MountCache::setMaxSize(qint64 bytes)
+{
+    QMutexLocker lock(&mtx);
+    cache.setMaxCost(static_cast<int>(bytes / 1024));
+}
+
+qint64 MountCache::maxSize() const
+{
+    QMutexLocker lock(&mtx);
+    return static_cast<qint64>(cache.maxCost()) * 1024;
+}
+
+qint64 MountCache::size() const
+{
+    QMutexLocker lock(&mtx);
+    return static_cast<qint64>(cache.totalCost()) * 1024;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __MOUNT_CACHE_H
+#define __MOUNT_CACHE_H
+
+#include <QString>
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+
+namespace QComicBook
+{
+    class ArchiveReader;
+
+	/**
+	 * @brief Process-wide LRU of archives mounted in memory, i.e. decompressed from an enclosing archive.
+	 *
+	 * Readers are kept together with their data and evicted least recently used first when total
+	 * size exceeds the limit. A reader returned by get() stays valid after eviction until the last
+	 * reference to it is released.
+	 */
+    class MountCache
+    {
+    public:
+        static MountCache& instance();
+
+		/**
+		 * @brief Returns mounted archive stored under given key or NULL pointer.
+		 */
+        QSharedPointer<ArchiveReader> get(const QString &key);
+
+		/**
+		 * @brief Stores mounted archive.
+		 *
+		 * @param key identifies the enclosing archive and the entry
+		 * @param reader reader opened with ArchiveReader::openData()
+		 * @param size size of the archive data held by reader
+		 */
+        void insert(const QString &key, const QSharedPointer<ArchiveReader> &reader, qint64 size);
+
+        void setMaxSize(qint64 bytes);
+        qint64 maxSize() const;
+        qint64 size() const;
+
+    private:
+        MountCache();
+        ~MountCache();
+
+        static const qint64 DEFAULT_SIZE;
+
+        mutable QMutex mtx;
+        QCache<QString, QSharedPointer<ArchiveReader> > cache; //!< costs are in kilobytes
+    };
+}
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "NestedArchiveReader.h"
+#include "ArchiversConfiguration.h"
+#include "MountCache.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QMutexLocker>
+#include "ComicBookDebug.h"
+
+using namespace QComicBook;
+
+NestedArchiveReader::NestedArchiveReader(const QSharedPointer<ArchiveReader> &outer): ArchiveReader(), m_outer(outer), m_pinnedMnt(-1)
+{
+}
+
+NestedArchiveReader::~NestedArchiveReader()
+{
+    //
+    // outer reader may still be used by others; it closes itself when the last reference goes
+}
+
+QString NestedArchiveReader::name() const
+{
+    return "nested " + m_outer->name();
+}
+
+bool NestedArchiveReader::isArchive(const QString &name)
+{
+    foreach (const QString ext, ArchiversConfiguration::instance().supportedOpenExtensions())
+    {
+        if (name.endsWith(ext.mid(1), Qt::CaseInsensitive)) //skip leading '*'
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString NestedArchiveReader::mountKey(int mnt) const
+{
+    return m_key + QString::number(m_mounts.at(mnt));
+}
+
+bool NestedArchiveReader::open(const QString &filename)
+{
+    if (m_outer->fileName() != filename || m_outer->entries().isEmpty())
+    {
+        if (!m_outer->open(filename))
+        {
+            return false;
+        }
+    }
+    m_filename = filename;
+    m_key = filename + '\n' + QFileInfo(filename).lastModified().toString(Qt::ISODate) + '\n';
+
+    const QList<ArchiveEntry> &outerEntries(m_outer->entries());
+    for (int i=0; i<outerEntries.size(); i++)
+    {
+        const ArchiveEntry &oe(outerEntries.at(i));
+        if (!isArchive(oe.name))
+        {
+            ArchiveEntry e(oe);
+            e.index = m_entries.size();
+            m_entries.append(e);
+            m_mountOf.append(-1);
+            m_entryOf.append(i);
+            continue;
+        }
+
+        QByteArray data(m_outer->read(i));
+        data.detach(); // may point into mapping of the outer archive, which can go away before the cache entry
+        QSharedPointer<ArchiveReader> inner(ArchiversConfiguration::instance().openReader(data));
+        if (!inner)
+        {
+            _DEBUG << "can't mount" << oe.name;
+            close();
+            return false;
+        }
+        const int mnt = m_mounts.size();
+        m_mounts.append(i);
+
+        const QList<ArchiveEntry> &innerEntries(inner->entries());
+        for (int j=0; j<innerEntries.size(); j++)
+        {
+            if (isArchive(innerEntries.at(j).name))
+            {
+                _DEBUG << "archive nested in" << oe.name << "found";
+                close();
+                return false;
+            }
+            ArchiveEntry e(innerEntries.at(j));
+            e.name = oe.name + '/' + e.name;
+            e.index = m_entries.size();
+            m_entries.append(e);
+            m_mountOf.append(mnt);
+            m_entryOf.append(j);
+        }
+
+        //
+        // the first pages will be read right away
+        MountCache::instance().insert(mountKey(mnt), inner, data.size());
+        if (mnt == 0)
+        {
+            QMutexLocker lock(&m_mountmtx);
+            m_pinned = inner;
+            m_pinnedMnt = mnt;
+        }
+    }
+
+    if (m_mounts.isEmpty())
+    {
+        close();
+        return false;
+    }
+    _DEBUG << "mounted" << m_mounts.size() << "archives of" << filename;
+    return true;
+}
+
+bool NestedArchiveReader::reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data)
+{
+    close();
+
+    QDataStream str(data);
+    str.setVersion(QDataStream::Qt_5_0);
+    QList<ArchiveEntry> outerEntries;
+    QByteArray outerData;
+    QList<int> mounts, mountOf, entryOf;
+    str >> outerEntries >> outerData >> mounts >> mountOf >> entryOf;
+    if (str.status() != QDataStream::Ok || mountOf.size() != entries.size() || entryOf.size() != entries.size())
+    {
+        return false;
+    }
+    for (int i=0; i<entries.size(); i++)
+    {
+        if (mountOf.at(i) >= mounts.size() || (mountOf.at(i) < 0 && entryOf.at(i) >= outerEntries.size()))
+        {
+            return false;
+        }
+    }
+    if (!m_outer->reopen(filename, outerEntries, outerData))
+    {
+        return false;
+    }
+
+    m_filename = filename;
+    m_key = filename + '\n' + QFileInfo(filename).lastModified().toString(Qt::ISODate) + '\n';
+    m_entries = entries;
+    m_mounts = mounts;
+    m_mountOf = mountOf;
+    m_entryOf = entryOf;
+    return true;
+}
+
+QByteArray NestedArchiveReader::indexData() const
+{
+    QByteArray data;
+    QDataStream str(&data, QIODevice::WriteOnly);
+    str.setVersion(QDataStream::Qt_5_0);
+    str << m_outer->entries() << m_outer->indexData() << m_mounts << m_mountOf << m_entryOf;
+    return data;
+}
+
+void NestedArchiveReader::close()
+{
+    m_outer->close();
+    m_mounts.clear();
+    m_mountOf.clear();
+    m_entryOf.clear();
+    m_key = QString::null;
+    m_mountmtx.lock();
+    m_pinned.clear();
+    m_pinnedMnt = -1;
+    m_mountmtx.unlock();
+    ArchiveReader::close();
+}
+
+QSharedPointer<ArchiveReader> NestedArchiveReader::mount(int mnt)
+{
+    const QString key(mountKey(mnt));
+    QSharedPointer<ArchiveReader> inner(MountCache::instance().get(key));
+    if (inner)
+    {
+        return inner;
+    }
+
+    QMutexLocker lock(&m_mountmtx);
+    //
+    // archives larger than the whole cache never get into it; pinned one is served from here
+    if (mnt == m_pinnedMnt)
+    {
+        return m_pinned;
+    }
+    inner = MountCache::instance().get(key); // mounted by another thread meanwhile?
+    if (!inner)
+    {
+        QByteArray data(m_outer->read(m_mounts.at(mnt)));
+        data.detach();
+        inner = QSharedPointer<ArchiveReader>(ArchiversConfiguration::instance().openReader(data));
+        if (inner)
+        {
+            _DEBUG << "mounted again" << m_outer->entries().at(m_mounts.at(mnt)).name;
+            MountCache::instance().insert(key, inner, data.size());
+        }
+    }
+    if (inner)
+    {
+        m_pinned = inner;
+        m_pinnedMnt = mnt;
+    }
+    return inner;
+}
+
+QByteArray NestedArchiveReader::read(int entry)
+{
+    if (entry < 0 || entry >= m_entries.size())
+    {
+        return QByteArray();
+    }
+    const int mnt = m_mountOf.at(entry);
+    if (mnt < 0)
+    {
+        return m_outer->read(m_entryOf.at(entry));
+    }
+    QSharedPointer<ArchiveReader> inner(mount(mnt));
+    return inner ? inner->read(m_entryOf.at(entry)) : QByteArray();
+}
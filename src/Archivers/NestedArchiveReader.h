@@ -0,0 +1,72 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __NESTED_ARCHIVE_READER_H
+#define __NESTED_ARCHIVE_READER_H
+
+#include "ArchiveReader.h"
+#include <QSharedPointer>
+#include <QMutex>
+
+namespace QComicBook
+{
+	/**
+	 * @brief Reader of archives that contain other archives, e.g. a volume packed from chapter archives.
+	 *
+	 * Archives stored in the outer one are mounted in memory with ArchiveReader::openData() and their
+	 * files are listed as "inner.cbz/page.jpg", next to regular files of the outer archive. Only one
+	 * level of nesting is supported. Mounted archives live in MountCache and are mounted again from
+	 * the outer archive after eviction, so no temporary files are needed. The archive mounted last
+	 * is also pinned by the reader, so one larger than the whole cache isn't mounted for every page.
+	 */
+    class NestedArchiveReader: public ArchiveReader
+    {
+    public:
+		/**
+		 * @param outer reader of the enclosing archive
+		 */
+        NestedArchiveReader(const QSharedPointer<ArchiveReader> &outer);
+        virtual ~NestedArchiveReader();
+
+		/**
+		 * @brief Opens the outer archive (unless outer reader has it open already) and mounts archives stored in it.
+		 *
+		 * @return false if there are no archives inside, any of them can't be read in memory or has archives inside
+		 */
+        virtual bool open(const QString &filename);
+        virtual bool reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data);
+        virtual void close();
+        virtual QByteArray read(int entry);
+        virtual QByteArray indexData() const;
+        virtual QString name() const;
+
+		/**
+		 * @brief Returns true if given entry name looks like an archive which can be mounted.
+		 */
+        static bool isArchive(const QString &name);
+
+    private:
+        QSharedPointer<ArchiveReader> mount(int mnt);
+        QString mountKey(int mnt) const;
+
+        QSharedPointer<ArchiveReader> m_outer;
+        QString m_key; //!< identifies current version of the outer archive in MountCache
+        QList<int> m_mounts; //!< outer entries of mounted archives
+        QList<int> m_mountOf; //!< for each entry: mount number or -1 for outer archive file
+        QList<int> m_entryOf; //!< for each entry: entry of the mounted (or outer) archive
+        QMutex m_mountmtx; //!< serializes mounting, so an archive isn't decompressed twice at once; guards m_pinned
+        QSharedPointer<ArchiveReader> m_pinned; //!< archive mounted last, kept regardless of MountCache
+        int m_pinnedMnt; //!< mount number of m_pinned; -1 if none
+    };
+}
+
+#endif
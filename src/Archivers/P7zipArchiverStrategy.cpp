@@ -16,6 +16,13 @@
 using namespace QComicBook;
 using Utility::which;
 
+//
+// "7z l" prints fixed-width columns: date, time, attributes, size and compressed size
+// (12 characters each, right-aligned) and two spaces before the name. Compressed size
+// is blank for all but the first file of a solid block, so the name is taken by column
+// rather than after the numbers; names starting with digits stay intact.
+static const char *LIST_PATTERN = "^\\d{4}-\\d\\d-\\d\\d \\d\\d:\\d\\d:\\d\\d \\.[.A-Z]{4} [ \\d]{12} [ \\d]{12}  (.+)$";
+
 P7zipArchiverStrategy::P7zipArchiverStrategy()
     : ArchiverStrategy("p7zip", FileSignature())
 {
@@ -36,12 +43,14 @@ void P7zipArchiverStrategy::configure()
     {
         setExtractArguments("7z x @F");
         setListArguments("7z l @F");
+        setListPattern(LIST_PATTERN);
         setSupported();
     }
     else if (which("7zr") != QString::null)
     {
         setExtractArguments("7zr x @F");
         setListArguments("7zr l @F");
+        setListPattern(LIST_PATTERN);
         setSupported();
     }
 }
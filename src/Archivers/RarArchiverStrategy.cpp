@@ -38,6 +38,7 @@ void RarArchiverStrategy::configure()
     {
         setExtractArguments("rar x @F");
         setListArguments("rar lb @F");
+        setListPattern("^(.+)$");
         setSupported();
     }
     else if (which("unrar") != QString::null)
@@ -61,6 +62,7 @@ void RarArchiverStrategy::configure()
             {
                 setExtractArguments("unrar x @F");
                 setListArguments("unrar lb @F");
+                setListPattern("^(.+)$");
             }
             else
             {
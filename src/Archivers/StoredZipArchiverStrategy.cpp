@@ -0,0 +1,47 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "StoredZipArchiverStrategy.h"
+#include "ZipReader.h"
+#include <QFile>
+
+using namespace QComicBook;
+
+StoredZipArchiverStrategy::StoredZipArchiverStrategy()
+    : ArchiverStrategy("zip (stored)", FileSignature(0, "\x50\x4b\x03\x04", 4))
+{
+}
+
+StoredZipArchiverStrategy::~StoredZipArchiverStrategy()
+{
+}
+
+void StoredZipArchiverStrategy::configure()
+{
+    addExtension(".zip");
+    addExtension(".cbz");
+    setExecutables("built-in");
+    setBuiltin();
+    setSupported();
+}
+
+bool StoredZipArchiverStrategy::canOpen(const QString &filename, const QByteArray &head) const
+{
+    //
+    // compressed archives are left for other readers
+    return ArchiverStrategy::canOpen(filename, head) && ZipReader::canRead(filename);
+}
+
+ArchiveReader* StoredZipArchiverStrategy::createReader() const
+{
+    return new ZipReader();
+}
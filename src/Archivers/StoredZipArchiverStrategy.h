@@ -0,0 +1,32 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __STORED_ZIP_ARCHIVER_STRATEGY_H
+#define __STORED_ZIP_ARCHIVER_STRATEGY_H
+
+#include "ArchiverStrategy.h"
+
+namespace QComicBook
+{
+    class StoredZipArchiverStrategy: public ArchiverStrategy
+    {
+    public:
+        StoredZipArchiverStrategy();
+        virtual ~StoredZipArchiverStrategy();
+
+        virtual void configure();
+        virtual bool canOpen(const QString &filename, const QByteArray &head) const;
+        virtual ArchiveReader* createReader() const;
+    };
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "TarArchiverStrategy.h"
+#include "TarReader.h"
+
+using namespace QComicBook;
+
+TarArchiverStrategy::TarArchiverStrategy()
+    : ArchiverStrategy("tar", FileSignature(257, "ustar", 5))
+{
+}
+
+TarArchiverStrategy::~TarArchiverStrategy()
+{
+}
+
+void TarArchiverStrategy::configure()
+{
+    addExtension(".tar");
+    addExtension(".cbt");
+    setExecutables("built-in");
+    setBuiltin();
+    setSupported();
+}
+
+ArchiveReader* TarArchiverStrategy::createReader() const
+{
+    return new TarReader();
+}
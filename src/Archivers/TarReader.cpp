@@ -0,0 +1,330 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "TarReader.h"
+#include <QFile>
+#include "ComicBookDebug.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+
+using namespace QComicBook;
+
+const int TarReader::BLOCK_SIZE = 512;
+const int TarReader::MAX_LONGNAME = 64*1024;
+
+TarReader::TarReader(): ArchiveReader(), fd(-1)
+{
+}
+
+TarReader::~TarReader()
+{
+    close();
+}
+
+qint64 TarReader::parseNumber(const char *p, int len)
+{
+    //
+    // GNU tar stores big numbers in base-256 with the highest bit set
+    if (static_cast<unsigned char>(p[0]) & 0x80)
+    {
+        if (static_cast<unsigned char>(p[0]) & 0x40)
+        {
+            return -1; // negative
+        }
+        qint64 n = static_cast<unsigned char>(p[0]) & 0x3f;
+        for (int i=1; i<len; i++)
+        {
+            if (n > (Q_INT64_C(0x7fffffffffffffff) >> 8))
+            {
+                return -1;
+            }
+            n = (n << 8) | static_cast<unsigned char>(p[i]);
+        }
+        return n;
+    }
+    qint64 n = 0;
+    int i = 0;
+    while (i < len && (p[i] == ' ' || p[i] == '\0'))
+    {
+        ++i;
+    }
+    //
+    // 12 octal digits at most, can't overflow
+    for (; i < len && p[i] >= '0' && p[i] <= '7'; i++)
+    {
+        n = n*8 + (p[i] - '0');
+    }
+    return n;
+}
+
+QByteArray TarReader::parseString(const char *p, int len)
+{
+    return QByteArray(p, qstrnlen(p, len));
+}
+
+bool TarReader::checksumValid(const char *header)
+{
+    unsigned int sum = 0;
+    for (int i=0; i<BLOCK_SIZE; i++)
+    {
+        //
+        // checksum field itself counts as spaces
+        sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(header[i]);
+    }
+    return sum == parseNumber(header + 148, 8);
+}
+
+QByteArray TarReader::paxPath(const QByteArray &records)
+{
+    //
+    // pax extended header consists of "<length> <key>=<value>\n" records
+    int pos = 0;
+    while (pos < records.size())
+    {
+        const int sp = records.indexOf(' ', pos);
+        if (sp < 0)
+        {
+            break;
+        }
+        const int len = records.mid(pos, sp - pos).toInt();
+        if (len <= 0 || pos + len > records.size())
+        {
+            break;
+        }
+        const QByteArray rec(records.mid(sp + 1, pos + len - sp - 2)); // without trailing newline
+        if (rec.startsWith("path="))
+        {
+            return rec.mid(5);
+        }
+        pos += len;
+    }
+    return QByteArray();
+}
+
+TarReader::HeaderType TarReader::headerType(const char *header, qint64 &size)
+{
+    size = 0;
+    if (header[0] == '\0')
+    {
+        return END;
+    }
+    if (!checksumValid(header))
+    {
+        return INVALID;
+    }
+    size = parseNumber(header + 124, 12);
+    //
+    // members are read into QByteArray; corrupted size would overflow it
+    if (size < 0 || size > INT_MAX)
+    {
+        return INVALID;
+    }
+    switch (header[156])
+    {
+        case 'L':
+        case 'x':
+            return (size > MAX_LONGNAME) ? INVALID : LONGNAME;
+        case '0':
+        case '\0':
+        case '7':
+            return MEMBER;
+        default:
+            return OTHER;
+    }
+}
+
+QByteArray TarReader::longName(const char *header, const QByteArray &data)
+{
+    return (header[156] == 'L') ? parseString(data.constData(), data.size()) : paxPath(data);
+}
+
+qint64 TarReader::paddedSize(qint64 size)
+{
+    return (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+}
+
+void TarReader::addEntry(const char *header, qint64 offset, int index, const QByteArray &longname)
+{
+    QByteArray fname(longname);
+    if (fname.isEmpty())
+    {
+        fname = parseString(header, 100);
+        if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+        {
+            fname = parseString(header + 345, 155) + "/" + fname;
+        }
+    }
+    if (fname.endsWith('/'))
+    {
+        return; // old tar directory entry
+    }
+    const qint64 size = parseNumber(header + 124, 12);
+    ArchiveEntry entry;
+    entry.name = QFile::decodeName(fname);
+    entry.index = index;
+    entry.offset = offset;
+    entry.compressedSize = size;
+    entry.size = size;
+    m_entries.append(entry);
+}
+
+bool TarReader::readData(qint64 offset, char *buf, qint64 len) const
+{
+    if (fd < 0)
+    {
+        if (offset < 0 || offset + len > buffer.size())
+        {
+            return false;
+        }
+        memcpy(buf, buffer.constData() + offset, len);
+        return true;
+    }
+
+    qint64 done = 0;
+    while (done < len)
+    {
+        const ssize_t n = pread(fd, buf + done, len - done, offset + done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+bool TarReader::openFile(const QString &filename)
+{
+    fd = ::open(QFile::encodeName(filename).constData(), O_RDONLY);
+    return fd >= 0;
+}
+
+bool TarReader::open(const QString &filename)
+{
+    close();
+    if (!openFile(filename) || !readHeaders())
+    {
+        close();
+        return false;
+    }
+    m_filename = filename;
+    return true;
+}
+
+bool TarReader::openData(const QByteArray &data)
+{
+    close();
+    buffer = data;
+    if (!readHeaders())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TarReader::readHeaders()
+{
+    char header[BLOCK_SIZE];
+    QByteArray longname;
+    qint64 offset = 0;
+    for (int i=0; readData(offset, header, BLOCK_SIZE); i++)
+    {
+        qint64 size;
+        const HeaderType type = headerType(header, size);
+        if (type == END)
+        {
+            break;
+        }
+        if (type == INVALID)
+        {
+            _DEBUG << "bad tar header at" << offset;
+            return false;
+        }
+        if (type == LONGNAME)
+        {
+            QByteArray data(static_cast<int>(size), '\0');
+            if (!readData(offset + BLOCK_SIZE, data.data(), size))
+            {
+                break;
+            }
+            longname = longName(header, data);
+        }
+        else
+        {
+            if (type == MEMBER)
+            {
+                addEntry(header, offset, i, longname);
+            }
+            longname.clear();
+        }
+        offset += BLOCK_SIZE + paddedSize(size);
+    }
+    return true;
+}
+
+bool TarReader::reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &)
+{
+    close();
+    if (!openFile(filename))
+    {
+        return false;
+    }
+    m_filename = filename;
+    m_entries = entries;
+    return true;
+}
+
+void TarReader::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    buffer.clear();
+    ArchiveReader::close();
+}
+
+QByteArray TarReader::read(int entry)
+{
+    if (entry < 0 || entry >= m_entries.size())
+    {
+        return QByteArray();
+    }
+    const ArchiveEntry &e(m_entries.at(entry));
+    if (e.size < 0 || e.size > INT_MAX)
+    {
+        return QByteArray();
+    }
+    QByteArray data(static_cast<int>(e.size), '\0');
+    if (!readData(e.offset + BLOCK_SIZE, data.data(), e.size))
+    {
+        _DEBUG << "can't read" << e.name;
+        return QByteArray();
+    }
+    return data;
+}
+
+QString TarReader::name() const
+{
+    return "tar";
+}
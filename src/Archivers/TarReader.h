@@ -0,0 +1,84 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __TAR_READER_H
+#define __TAR_READER_H
+
+#include "ArchiveReader.h"
+
+namespace QComicBook
+{
+	/**
+	 * @brief Random-access reader of uncompressed (ustar, GNU and pax) tar archives.
+	 *
+	 * Headers are scanned once on open; read() fetches a single member with pread(),
+	 * so it doesn't depend on any other member and may be called from many threads.
+	 */
+    class TarReader: public ArchiveReader
+    {
+    public:
+        TarReader();
+        virtual ~TarReader();
+
+        virtual bool open(const QString &filename);
+        virtual bool openData(const QByteArray &data);
+        virtual bool reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data);
+        virtual void close();
+        virtual QByteArray read(int entry);
+        virtual QString name() const;
+
+    protected:
+        enum HeaderType
+        {
+            MEMBER, //!< regular file
+            LONGNAME, //!< GNU long name or pax extended header of the next member
+            OTHER, //!< directory, link or any other member that is skipped
+            END, //!< end of archive marker
+            INVALID //!< not a tar header
+        };
+
+        //! Returns type of the header block; size receives size of member data following the header.
+        /*! Headers with sizes that can't be read into memory (negative, over 2GB, or long names
+         *  over MAX_LONGNAME) are INVALID. */
+        static HeaderType headerType(const char *header, qint64 &size);
+
+        //! Returns name of the next member stored in data of LONGNAME header.
+        static QByteArray longName(const char *header, const QByteArray &data);
+
+        //! Returns size of member data rounded up to whole blocks.
+        static qint64 paddedSize(qint64 size);
+
+        //! Appends regular file described by the header at given offset to entries.
+        void addEntry(const char *header, qint64 offset, int index, const QByteArray &longname);
+
+        //! Reads uncompressed archive data; may be called from many threads.
+        virtual bool readData(qint64 offset, char *buf, qint64 len) const;
+
+        bool openFile(const QString &filename);
+
+        static const int BLOCK_SIZE;
+        static const int MAX_LONGNAME; //!< maximum size of long name or pax header data
+
+        int fd; //!< archive file descriptor
+        QByteArray buffer; //!< archive contents if opened with openData()
+
+    private:
+        bool readHeaders();
+        //! @return -1 if number is negative or doesn't fit in qint64
+        static qint64 parseNumber(const char *p, int len);
+        static QByteArray parseString(const char *p, int len);
+        static bool checksumValid(const char *header);
+        static QByteArray paxPath(const QByteArray &records);
+    };
+}
+
+#endif
@@ -35,6 +35,7 @@ void Tarbz2ArchiverStrategy::configure()
     {
         setExtractArguments("tar -xvjf @F");
         setListArguments("tar -tjf @F");
+        setListPattern("^(.+)$");
         setSupported();
     }
 }
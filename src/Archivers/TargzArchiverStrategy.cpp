@@ -36,6 +36,7 @@ void TargzArchiverStrategy::configure()
     {
         setExtractArguments("tar -xvzf @F");
         setListArguments("tar -tzf @F");
+        setListPattern("^(.+)$");
         setSupported();
     }
 }
@@ -36,6 +36,7 @@ void ZipArchiverStrategy::configure()
     {
         setExtractArguments("unzip @F");
         setListArguments("unzip -l @F");
+        setListPattern("^\\s*\\d+\\s+\\S+\\s+\\d+:\\d+\\s+(.+)$");
         setSupported();
     }
 }
@@ -0,0 +1,239 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "ZipReader.h"
+#include "ComicBookDebug.h"
+
+using namespace QComicBook;
+
+//
+// zip format constants, see PKWARE APPNOTE.TXT
+namespace
+{
+    const quint32 LOCAL_HEADER_SIG = 0x04034b50;
+    const quint32 CENTRAL_HEADER_SIG = 0x02014b50;
+    const quint32 EOCD_SIG = 0x06054b50;
+    const int LOCAL_HEADER_SIZE = 30;
+    const int CENTRAL_HEADER_SIZE = 46;
+    const int EOCD_SIZE = 22;
+    const int MAX_COMMENT_SIZE = 65535;
+    const quint16 FLAG_ENCRYPTED = 0x0001;
+    const quint16 FLAG_UTF8 = 0x0800;
+    const quint16 METHOD_STORED = 0;
+}
+
+ZipReader::ZipReader(): ArchiveReader(), data(NULL), size(0)
+{
+}
+
+ZipReader::~ZipReader()
+{
+    close();
+}
+
+quint16 ZipReader::get16(const uchar *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+quint32 ZipReader::get32(const uchar *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<quint32>(p[3]) << 24);
+}
+
+bool ZipReader::readCentralDirectory(const uchar *data, qint64 size, QList<ArchiveEntry> &entries)
+{
+    if (size < EOCD_SIZE)
+    {
+        return false;
+    }
+
+    //
+    // end of central directory record is followed only by archive comment
+    const uchar *eocd = NULL;
+    const qint64 minpos = qMax(static_cast<qint64>(0), size - EOCD_SIZE - MAX_COMMENT_SIZE);
+    for (qint64 pos = size - EOCD_SIZE; pos >= minpos; pos--)
+    {
+        if (get32(data + pos) == EOCD_SIG)
+        {
+            eocd = data + pos;
+            break;
+        }
+    }
+    if (!eocd)
+    {
+        return false;
+    }
+
+    const int count = get16(eocd + 10);
+    const qint64 cdsize = get32(eocd + 12);
+    const qint64 cdoffset = get32(eocd + 16);
+    if (get16(eocd + 4) != 0 || count == 0xffff || cdoffset == 0xffffffff || cdoffset + cdsize > size)
+    {
+        return false; // multi-volume or zip64 archive
+    }
+
+    const uchar *p = data + cdoffset;
+    const uchar *end = p + cdsize;
+    for (int i=0; i<count; i++)
+    {
+        if (p + CENTRAL_HEADER_SIZE > end || get32(p) != CENTRAL_HEADER_SIG)
+        {
+            return false;
+        }
+        const quint16 flags = get16(p + 8);
+        const quint16 method = get16(p + 10);
+        const qint64 csize = get32(p + 20);
+        const qint64 usize = get32(p + 24);
+        const int namelen = get16(p + 28);
+        const int extralen = get16(p + 30);
+        const int commentlen = get16(p + 32);
+        const qint64 offset = get32(p + 42);
+        const uchar *next = p + CENTRAL_HEADER_SIZE + namelen + extralen + commentlen;
+        if (next > end)
+        {
+            return false;
+        }
+
+        const char *n = reinterpret_cast<const char *>(p + CENTRAL_HEADER_SIZE);
+        const QString fname((flags & FLAG_UTF8) ? QString::fromUtf8(n, namelen) : QFile::decodeName(QByteArray(n, namelen)));
+        if (!fname.endsWith('/'))
+        {
+            if (method != METHOD_STORED || (flags & FLAG_ENCRYPTED) || csize != usize || offset + LOCAL_HEADER_SIZE + csize > size)
+            {
+                return false;
+            }
+            ArchiveEntry entry;
+            entry.name = fname;
+            entry.index = i;
+            entry.offset = offset;
+            entry.compressedSize = csize;
+            entry.size = usize;
+            entries.append(entry);
+        }
+        p = next;
+    }
+    return true;
+}
+
+bool ZipReader::map(const QString &filename)
+{
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    size = file.size();
+    data = file.map(0, size);
+    if (!data)
+    {
+        _DEBUG << "can't map" << filename;
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool ZipReader::canRead(const QString &filename)
+{
+    ZipReader r;
+    QList<ArchiveEntry> entries;
+    return r.map(filename) && readCentralDirectory(r.data, r.size, entries) && entries.size() > 0;
+}
+
+bool ZipReader::open(const QString &filename)
+{
+    close();
+    if (!map(filename))
+    {
+        return false;
+    }
+    if (!readCentralDirectory(data, size, m_entries))
+    {
+        close();
+        return false;
+    }
+    m_filename = filename;
+    return true;
+}
+
+bool ZipReader::openData(const QByteArray &contents)
+{
+    close();
+    buffer = contents;
+    data = reinterpret_cast<uchar *>(const_cast<char *>(buffer.constData()));
+    size = buffer.size();
+    if (!readCentralDirectory(data, size, m_entries))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ZipReader::reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &)
+{
+    close();
+    if (!map(filename))
+    {
+        return false;
+    }
+    m_filename = filename;
+    m_entries = entries;
+    return true;
+}
+
+void ZipReader::close()
+{
+    if (data && buffer.isEmpty())
+    {
+        file.unmap(data);
+    }
+    data = NULL;
+    buffer.clear();
+    size = 0;
+    file.close();
+    ArchiveReader::close();
+}
+
+QByteArray ZipReader::read(int entry)
+{
+    if (entry < 0 || entry >= m_entries.size())
+    {
+        return QByteArray();
+    }
+    const ArchiveEntry &e(m_entries.at(entry));
+
+    //
+    // local header may have different extra field than central directory one
+    const uchar *local = data + e.offset;
+    if (e.offset + LOCAL_HEADER_SIZE > size || get32(local) != LOCAL_HEADER_SIG)
+    {
+        _DEBUG << "bad local header of" << e.name;
+        return QByteArray();
+    }
+    const qint64 start = e.offset + LOCAL_HEADER_SIZE + get16(local + 26) + get16(local + 28);
+    if (start + e.size > size)
+    {
+        return QByteArray();
+    }
+    if (!buffer.isEmpty())
+    {
+        return buffer.mid(start, e.size);
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(data + start), e.size);
+}
+
+QString ZipReader::name() const
+{
+    return "zip";
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __ZIP_READER_H
+#define __ZIP_READER_H
+
+#include "ArchiveReader.h"
+#include <QFile>
+
+namespace QComicBook
+{
+	/**
+	 * @brief Reader of zip archives with stored (uncompressed) entries only, e.g. created with zip -0.
+	 *
+	 * The archive is memory-mapped and read() returns data pointing directly into the mapping,
+	 * so pages are neither copied nor decompressed. Data returned by read() is valid as long
+	 * as the reader exists. Archives opened with openData() return copies instead, so the
+	 * data outlives the reader.
+	 */
+    class ZipReader: public ArchiveReader
+    {
+    public:
+        ZipReader();
+        virtual ~ZipReader();
+
+        virtual bool open(const QString &filename);
+        virtual bool openData(const QByteArray &data);
+        virtual bool reopen(const QString &filename, const QList<ArchiveEntry> &entries, const QByteArray &data);
+        virtual void close();
+        virtual QByteArray read(int entry);
+        virtual QString name() const;
+
+		/**
+		 * @brief Return true if given file is a zip archive and all its files are stored without compression.
+		 */
+        static bool canRead(const QString &filename);
+
+    private:
+        bool map(const QString &filename);
+        static bool readCentralDirectory(const uchar *data, qint64 size, QList<ArchiveEntry> &entries);
+        static quint16 get16(const uchar *p);
+        static quint32 get32(const uchar *p);
+
+        QFile file;
+        QByteArray buffer; //!< archive contents if opened with openData()
+        uchar *data; //!< mapped archive or contents of buffer
+        qint64 size; //!< size of mapped archive
+    };
+}
+
+#endif
@@ -49,6 +49,8 @@ ComicBookCfgDialog::ComicBookCfgDialog(QWidget *parent, ComicBookSettings *cfg):
     sb_cachesize->setValue(cfg->cacheSize());
     cb_cacheadjust->setChecked(cfg->cacheAutoAdjust());
     cb_preload->setChecked(cfg->preloadPages());
+    cb_bulkread->setChecked(cfg->bulkRead());
+    sb_decodethreads->setValue(cfg->decodeThreads());
 
     cb_autoinfo->setChecked(cfg->autoInfo());
     cb_thumbs->setChecked(cfg->cacheThumbnails());
@@ -82,6 +84,8 @@ void ComicBookCfgDialog::accept()
 	cfg->cacheSize(sb_cachesize->value());
 	cfg->cacheAutoAdjust(cb_cacheadjust->isChecked());
 	cfg->preloadPages(cb_preload->isChecked());
+	cfg->bulkRead(cb_bulkread->isChecked());
+	cfg->decodeThreads(sb_decodethreads->value());
 	cfg->cacheThumbnails(cb_thumbs->isChecked());
 	cfg->thumbnailsAge(sb_thumbsage->value());
 	cfg->autoInfo(cb_autoinfo->isChecked());
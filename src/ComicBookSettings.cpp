@@ -20,6 +20,7 @@
 #include <QDir>
 #include <QTextStream>
 #include <QStandardPaths>
+#include <QThread>
 #include <iostream>
 #include "ComicBookDebug.h"
 
@@ -60,6 +61,8 @@
 #define OPT_THUMBSAGE   "/ThumbnailsAge"
 #define OPT_CACHETHUMBS "/CacheThumbnails"
 #define OPT_PRELOAD     "/Preload"
+#define OPT_BULKREAD    "/BulkRead"
+#define OPT_DECODETHREADS "/DecodeThreads"
 #define OPT_CONFIRMEXIT "/ConfirmExit"
 #define OPT_SHOWSPLASH  "/ShowSplashscreen"
 #define OPT_TMPDIR      "/TmpDir"
@@ -129,6 +132,17 @@ bool ComicBookSettings::checkDirs()
                 return false;
             }
         }
+
+        m_idxpath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "index";
+
+        dir.setPath(m_idxpath);
+	if (!dir.exists())
+        {
+            if (!dir.mkpath(m_idxpath))
+            {
+                return false;
+            }
+        }
 	return m_dirsok = true;
 }
 
@@ -142,6 +156,11 @@ const QString& ComicBookSettings::thumbnailsDir()
 	return m_thpath;
 }
 
+const QString& ComicBookSettings::indexDir()
+{
+	return m_idxpath;
+}
+
 void ComicBookSettings::load()
 {
 	QString fontdesc;
@@ -187,6 +206,8 @@ void ComicBookSettings::load()
                 }
 		m_cacheadjust = m_cfg->value(OPT_CACHEADJUST, true).toBool();
 		m_preload = m_cfg->value(OPT_PRELOAD, true).toBool();
+		m_bulkread = m_cfg->value(OPT_BULKREAD, false).toBool();
+		m_decodethreads = qBound(1, m_cfg->value(OPT_DECODETHREADS, qMin(QThread::idealThreadCount(), 4)).toInt(), 16);
 		m_confirmexit = m_cfg->value(OPT_CONFIRMEXIT, true).toBool();
 		m_autoinfo = m_cfg->value(OPT_AUTOINFO, false).toBool();
 		m_showsplash = m_cfg->value(OPT_SHOWSPLASH, true).toBool();
@@ -300,6 +321,16 @@ bool ComicBookSettings::preloadPages() const
     return m_preload;
 }
 
+bool ComicBookSettings::bulkRead() const
+{
+    return m_bulkread;
+}
+
+int ComicBookSettings::decodeThreads() const
+{
+    return m_decodethreads;
+}
+
 bool ComicBookSettings::confirmExit() const
 {
 	return m_confirmexit;
@@ -533,6 +564,23 @@ void ComicBookSettings::preloadPages(bool f)
     }
 }
 
+void ComicBookSettings::bulkRead(bool f)
+{
+    if (f != m_bulkread)
+    {
+        m_cfg->setValue(GRP_MISC OPT_BULKREAD, m_bulkread = f);
+    }
+}
+
+void ComicBookSettings::decodeThreads(int n)
+{
+    n = qBound(1, n, 16);
+    if (n != m_decodethreads)
+    {
+        m_cfg->setValue(GRP_MISC OPT_DECODETHREADS, m_decodethreads = n);
+    }
+}
+
 void ComicBookSettings::confirmExit(bool f)
 {
     if (f != m_confirmexit)
@@ -57,6 +57,8 @@ namespace QComicBook
 			bool cacheThumbnails() const;
 			int thumbnailsAge() const;
 			bool preloadPages() const;
+			bool bulkRead() const;
+			int decodeThreads() const;
 			bool confirmExit() const;
 			bool autoInfo() const;
 			bool fullScreenHideMenu() const;
@@ -90,6 +92,8 @@ namespace QComicBook
 			void cacheThumbnails(bool f);
 			void thumbnailsAge(int n);
 			void preloadPages(bool f);
+			void bulkRead(bool f);
+			void decodeThreads(int n);
 			void confirmExit(bool f);
 			void autoInfo(bool f);
 			void fullScreenHideMenu(bool f);
@@ -112,6 +116,7 @@ namespace QComicBook
 			bool checkDirs();
 			const QString& bookmarksDir();
 			const QString& thumbnailsDir();
+			const QString& indexDir();
 
 		private:
 			QSettings *m_cfg;
@@ -123,6 +128,7 @@ namespace QComicBook
 			bool m_contscroll;
 			bool m_scrollbars;
 			bool m_preload;
+			bool m_bulkread;
 			bool m_fscrhidemenu;
 			bool m_fscrhidestatus;
 			bool m_fscrhidetoolbar;
@@ -134,6 +140,7 @@ namespace QComicBook
 			QColor m_bgcolor;
 			QStringList m_recent;
 			int m_cachesize;
+			int m_decodethreads;
 			int m_gapsize;
 			int m_thumbsage;
 			bool m_cacheadjust;
@@ -150,6 +157,7 @@ namespace QComicBook
 
 			QString m_bkpath; //bookmarks path
 			QString m_thpath; //thumbnails cache path
+			QString m_idxpath; //comic book indexes cache path
 			bool m_dirsok; //is above dirs are ok
 
 			static const EnumMap<Size> size2string[];
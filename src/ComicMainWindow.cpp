@@ -21,6 +21,10 @@
 #include "Archivers/ArchiversConfiguration.h"
 #include "Sink/ImgDirSink.h"
 #include "Sink/ImgSinkFactory.h"
+#include "Sink/SinkOpener.h"
+#include "Sink/PageSizeProbe.h"
+#include "Sink/SinkReaper.h"
+#include "Sink/BookIndex.h"
 #include "AboutDialog.h"
 #include "ui_DonationDialog.h"
 #include "ComicBookSettings.h"
@@ -57,11 +61,15 @@
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QApplication>
+#include <QDesktopWidget>
 #include "ComicBookDebug.h"
 #include <QFile>
 using namespace QComicBook;
 using namespace Utility;
 
+static const int PREOPEN_DISTANCE = 5; //!< number of pages from either end of the book that triggers opening of the adjacent one
+static const int PREOPEN_PAGES = 2; //!< number of leading pages of the adjacent book that are loaded in advance
+
 ComicMainWindow::ComicMainWindow(QWidget *parent): QMainWindow(parent), currpage(0)
 #ifdef DEBUG
                                                  , debugController(new DebugController(this))
@@ -75,7 +83,7 @@ ComicMainWindow::ComicMainWindow(QWidget *parent): QMainWindow(parent), currpage
     
     printer = QSharedPointer<QPrinter>(new QPrinter());
 
-    pageLoader = new PageLoaderThread();
+    pageLoader = new PageLoaderThread(cfg->decodeThreads());
     frameDetect = new FrameDetectThread();
 
     //
@@ -303,17 +311,32 @@ ComicMainWindow::ComicMainWindow(QWidget *parent): QMainWindow(parent), currpage
 
     thumbnailLoader = new ThumbnailLoaderThread();
     connect(thumbnailLoader, SIGNAL(thumbnailLoaded(const Thumbnail &)), thumbswin, SLOT(setThumbnail(const Thumbnail &)));
-    thumbnailLoader->start();
+    thumbnailLoader->start(QThread::LowPriority); //thumbnails give way to pages
 }
 
 ComicMainWindow::~ComicMainWindow()
 {
     ImageTransformThread::get()->stop();
 
+    if (opener)
+    {
+        opener->cancel();
+        opener->wait();
+        delete opener;
+    }
+    if (preopener)
+    {
+        preopener->cancel();
+        preopener->wait();
+        delete preopener;
+    }
+    presink.clear();
+
     if (cfg->cacheThumbnails())
     {
         ImgDirSink::removeThumbnails(cfg->thumbnailsAge());
     }
+    BookIndex::removeOld(cfg->thumbnailsAge());
 
     saveSettings();        
     
@@ -329,8 +352,14 @@ ComicMainWindow::~ComicMainWindow()
     
     if (sink)
     {
+        sink->close(); //sink itself is deleted later
         sink.clear();
     }
+
+    //
+    // temporary files of closed sinks are removed in background; finish it
+    SinkReaper::get()->stop();
+    SinkReaper::get()->wait();
 }
 
 void ComicMainWindow::setupContextMenu()
@@ -416,6 +445,8 @@ void ComicMainWindow::setupComicImageView()
     view->setFocus();
 
     reconfigureDisplay();
+    updateDecodeSize();
+    probePageSizes();
     
     connect(actionPageTop, SIGNAL(triggered(bool)), view, SLOT(scrollToTop()));
     connect(actionPageBottom, SIGNAL(triggered(bool)), view, SLOT(scrollToBottom()));
@@ -447,6 +478,9 @@ void ComicMainWindow::setupComicImageView()
     connect(view, SIGNAL(pageReady(const Page &, const Page &)), this, SLOT(pageLoaded(const Page &, const Page &)));
     connect(view, SIGNAL(requestPage(int)), pageLoader, SLOT(request(int)));
     connect(view, SIGNAL(requestTwoPages(int)), pageLoader, SLOT(requestTwoPages(int)));
+    connect(view, SIGNAL(preloadPage(int)), pageLoader, SLOT(preload(int)));
+    connect(view, SIGNAL(preloadTwoPages(int)), pageLoader, SLOT(preloadTwoPages(int)));
+    connect(view, SIGNAL(currentPageChanged(int)), pageLoader, SLOT(setFocusPage(int)));
     connect(view, SIGNAL(cancelPageRequest(int)), pageLoader, SLOT(cancel(int)));
     connect(view, SIGNAL(cancelTwoPagesRequest(int)), pageLoader, SLOT(cancelTwoPages(int)));
 
@@ -628,6 +662,7 @@ void ComicMainWindow::setPageSize(QAction *action)
     }
     cfg->pageSize(size);
     view->setSize(size);
+    updateDecodeSize();
 }
 
 void ComicMainWindow::setLensZoom(QAction *action)
@@ -705,8 +740,14 @@ void ComicMainWindow::sinkReady(const QString &path)
         updateCaption();
         statusbar->setName(sink->getFullName());
 
+        //
+        // connected before the number of pages is read; directory books keep finding pages after open
+        connect(sink.data(), SIGNAL(pageChanged(int)), this, SLOT(sinkPageChanged(int)));
+        connect(sink.data(), SIGNAL(pagesAdded(int)), this, SLOT(sinkPagesAdded(int)));
+
         view->setNumOfPages(sink->numOfImages()); //FIXME
         thumbswin->view()->setPages(sink->numOfImages());
+        probePageSizes();
 
         //
         // request thumbnails for all pages
@@ -717,6 +758,10 @@ void ComicMainWindow::sinkReady(const QString &path)
         
         jumpToPage(currpage, true);
 
+        //
+        // pick up pages modified or added while the book is being read
+        sink->watchChanges();
+
 	const bool hasdesc = (sink->getDescription().count() > 0);
 	actionShowInfo->setDisabled(!hasdesc);
 
@@ -724,6 +769,57 @@ void ComicMainWindow::sinkReady(const QString &path)
                 showInfo();
 }
 
+void ComicMainWindow::sinkPageChanged(int page)
+{
+        if (!sink)
+                return;
+        if (page >= currpage && page < currpage + qMax(1, view->visiblePages()))
+                reloadPage();
+        if (thumbswin->isVisible())
+                thumbnailLoader->request(page);
+}
+
+void ComicMainWindow::sinkPagesAdded(int total)
+{
+        //
+        // signal may come from a closed sink or be older than the count read in sinkReady()
+        if (!sink || sender() != sink.data())
+                return;
+        const int old = view->numOfPages();
+        if (total <= old)
+                return;
+        view->setNumOfPages(total);
+        thumbswin->view()->addPages(total);
+        if (thumbswin->isVisible() && total > old)
+                thumbnailLoader->request(old, total - old);
+}
+
+void ComicMainWindow::probePageSizes()
+{
+        if (probe)
+                probe->cancel();
+        probe = NULL;
+
+        //
+        // only continuous view lays out pages that are not loaded
+        if (!sink || cfg->viewType() != Continuous)
+                return;
+        probe = new PageSizeProbe(sink);
+        connect(probe, SIGNAL(sizesProbed(int, const QList<QSize> &)), this, SLOT(pageSizesProbed(int, const QList<QSize> &)));
+        //
+        // pages of progressively opened archives and directories still being listed come later
+        connect(sink.data(), SIGNAL(pagesAvailable(int)), probe, SLOT(morePages()));
+        connect(sink.data(), SIGNAL(pagesAdded(int)), probe, SLOT(morePages()));
+        probe->start();
+}
+
+void ComicMainWindow::pageSizesProbed(int first, const QList<QSize> &sizes)
+{
+        if (sender() != probe) //sizes of a closed book or a replaced view
+                return;
+        view->setPageSizes(first, sizes);
+}
+
 void ComicMainWindow::sinkError(int code)
 {
 	statusbar->setShown(actionToggleStatusbar->isChecked() && !(isFullScreen() && cfg->fullScreenHideStatusbar())); //applies back user's statusbar&toolbar preferences
@@ -766,28 +862,137 @@ void ComicMainWindow::open(const QString &path, int page)
 
         if (sink && sink->getFullName() == fullname) //trying to open same dir?
                 return;
+        if (opener && opener->path() == fullname) //already being opened
+                return;
 
         lastdir = f.absolutePath();
         currpage = page;
 
+        if (preopener && preopener->path() == fullname)
+        {
+                //
+                // the book is being opened in background already; take it over
+                SinkOpener *o = preopener;
+                preopener = NULL;
+                closeSink();
+                o->disconnect(this);
+                connect(o->sink().data(), SIGNAL(progress(int, int)), statusbar, SLOT(setProgress(int, int)));
+                statusbar->setShown(true);
+                opener = o;
+                connect(opener, SIGNAL(opened(int)), this, SLOT(sinkOpened(int)));
+                return;
+        }
+        if (presink && presink->getFullName() == fullname)
+        {
+                const QSharedPointer<ImgSink> s = presink;
+                presink.clear();
+                closeSink();
+                attachSink(s);
+                sinkReady(fullname);
+                return;
+        }
+        cancelPreopen();
+
         closeSink();
 
-        sink = ImgSinkFactory::instance().createImgSink(path);
-	sink->setCacheSize(cfg->cacheSize()*1024*1024, cfg->cacheAutoAdjust());
+        QSharedPointer<ImgSink> newsink = ImgSinkFactory::instance().createImgSink(path);
+	newsink->setCacheSize(cfg->cacheSize()*1024*1024, cfg->cacheAutoAdjust());
+	newsink->setBulkRead(cfg->bulkRead());
+	newsink->setDecodeSize(decodeSize());
+
+        connect(newsink.data(), SIGNAL(progress(int, int)), statusbar, SLOT(setProgress(int, int)));
+
+        statusbar->setShown(true); //ensures status bar is visible when opening regardless of user settings
+
+        //
+        // window stays responsive while the book is opened; opening another one cancels this one
+        opener = new SinkOpener(newsink, fullname);
+        connect(opener, SIGNAL(opened(int)), this, SLOT(sinkOpened(int)));
+        opener->start();
+}
 
+void ComicMainWindow::attachSink(const QSharedPointer<ImgSink> &s)
+{
+        sink = s;
         pageLoader->setSink(sink);
         thumbnailLoader->setSink(sink);
         thumbnailLoader->setUseCache(cfg->cacheThumbnails());
+        sink->setDecodeSize(decodeSize()); //view settings might have changed since preopen
 
-        connect(sink.data(), SIGNAL(progress(int, int)), statusbar, SLOT(setProgress(int, int)));
+        connect(sink.data(), SIGNAL(pagesAvailable(int)), pageLoader, SLOT(pagesAvailable(int)));
+        connect(sink.data(), SIGNAL(pagesAvailable(int)), thumbnailLoader, SLOT(pagesAvailable(int)));
+}
 
-        statusbar->setShown(true); //ensures status bar is visible when opening regardless of user settings
+int ComicMainWindow::decodeSize() const
+{
+        //
+        // fitted page is never larger than the longer side of the screen;
+        // original size and frames zoomed in need full resolution
+        if (cfg->pageSize() == Original || cfg->viewType() == Frame)
+                return 0;
+        const QRect screen(QApplication::desktop()->screenGeometry(this));
+        return qMax(screen.width(), screen.height()) * devicePixelRatio();
+}
+
+void ComicMainWindow::updateDecodeSize()
+{
+        if (sink && sink->setDecodeSize(decodeSize()))
+                reloadPage();
+}
 
-        int status = sink->open(fullname);
+void ComicMainWindow::sinkOpened(int status)
+{
+        SinkOpener *o = qobject_cast<SinkOpener *>(sender());
+        if (!o || o != opener)
+                return;
+        opener = NULL;
+
+        attachSink(o->sink());
 	if (status)
 		sinkError(status);
 	else
-		sinkReady(fullname);
+		sinkReady(o->path());
+}
+
+void ComicMainWindow::preopen(const QString &path)
+{
+        if (path.isEmpty())
+                return;
+        const QString fullname = QFileInfo(path).absoluteFilePath();
+        if ((preopener && preopener->path() == fullname) || (presink && presink->getFullName() == fullname))
+                return;
+
+        cancelPreopen();
+
+        QSharedPointer<ImgSink> s = ImgSinkFactory::instance().createImgSink(fullname);
+        s->setCacheSize(cfg->cacheSize()*1024*1024, cfg->cacheAutoAdjust());
+        s->setBulkRead(cfg->bulkRead());
+        s->setDecodeSize(decodeSize());
+        preopener = new SinkOpener(s, fullname);
+        preopener->setWarmPages(PREOPEN_PAGES);
+        connect(preopener, SIGNAL(opened(int)), this, SLOT(sinkPreopened(int)));
+        preopener->start(QThread::LowPriority);
+}
+
+void ComicMainWindow::sinkPreopened(int status)
+{
+        SinkOpener *o = qobject_cast<SinkOpener *>(sender());
+        if (!o || o != preopener)
+                return;
+        preopener = NULL;
+        if (status == 0)
+                presink = o->sink();
+}
+
+void ComicMainWindow::cancelPreopen()
+{
+        if (preopener)
+        {
+                preopener->disconnect(this);
+                preopener->cancel();
+                preopener = NULL;
+        }
+        presink.clear();
 }
 
 void ComicMainWindow::openNext()
@@ -934,6 +1139,7 @@ void ComicMainWindow::currentPageChanged(int n)
 {
     _DEBUG << n;
 
+    const int prevpage = currpage;
     currpage = n;
     const QString page = tr("Page") + " " + QString::number(n + 1) + "/" + QString::number(sink->numOfImages());
     pageinfo->setText(page);
@@ -963,6 +1169,16 @@ void ComicMainWindow::currentPageChanged(int n)
     }
 
     thumbswin->view()->scrollToPage(n);
+
+    //
+    // open neighbouring volume in background when getting close to either end
+    if (sink && sink->supportsNext())
+    {
+        if (n >= sink->numOfImages() - PREOPEN_DISTANCE)
+            preopen(sink->getNext());
+        else if (n < prevpage && n < PREOPEN_DISTANCE)
+            preopen(sink->getPrevious());
+    }
 }
 
 void ComicMainWindow::showInfo()
@@ -1042,9 +1258,27 @@ void ComicMainWindow::closeSink()
 
     enableComicBookActions(false);
 
+    if (opener)
+    {
+        //
+        // don't wait for the open in progress; opener releases its sink when done
+        opener->disconnect(this);
+        opener->sink()->disconnect(statusbar);
+        opener->cancel();
+        opener = NULL;
+    }
+
+    if (probe)
+    {
+        probe->cancel();
+        probe = NULL;
+    }
+
     if (sink)
     {
 	frameDetect->clear();
+        sink->disconnect(this);
+        ImageTransformThread::get()->cancel();
         pageLoader->cancelAll();
         pageLoader->setSink();
         thumbnailLoader->cancelAll();
@@ -1107,7 +1341,20 @@ void ComicMainWindow::savePageAs()
             }
             QFileInfo newi(fname);
             cfg->saveDir(newi.absolutePath());
-            bool copy = QFile::copy(page, fname);//TODO: copy fails if file already exists: leave this 'feature' or fix by deleting old file -> dialog 'do you want to overwrite?' ???
+            //
+            // pages read in-process from archive have no file on disk; their entry is written as is,
+            // as decoded image may be recompressed lossily or scaled down to display resolution
+            bool copy;
+            if (QFile::exists(page))
+            {
+                copy = QFile::copy(page, fname); //TODO: copy fails if file already exists: leave this 'feature' or fix by deleting old file -> dialog 'do you want to overwrite?' ???
+            }
+            else
+            {
+                const QByteArray data(sink->getPageData(currpage + i));
+                QFile f(fname);
+                copy = data.isEmpty() ? img.getImage().save(fname) : (f.open(QIODevice::WriteOnly|QIODevice::Truncate) && f.write(data) == data.size());
+            }
             if (result != 0 || !copy) 
             {
                 QMessageBox::critical(this, tr("QComicBook error"), tr("Error saving image"), QMessageBox::Ok, QMessageBox::NoButton);
@@ -1123,6 +1370,7 @@ void ComicMainWindow::openPrintDialog()
     printdlg.setMinMax(1, sink->numOfImages());
     if (printdlg.exec() == QDialog::Accepted)
     {
+        sink->setDecodeSize(0); //print at full resolution
         PrintProgressDialog *progressdlg = new PrintProgressDialog(this);
         printThread = new PrinterThread(sink, printer, printdlg.printRange(), printdlg.fromPage(), printdlg.toPage());
         connect(printThread, SIGNAL(printing(int)), progressdlg, SLOT(setPage(int)));
@@ -1219,4 +1467,5 @@ void ComicMainWindow::printingFinished()
     _DEBUG;
 
     printThread->deleteLater();
+    updateDecodeSize();
 }
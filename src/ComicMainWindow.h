@@ -30,6 +30,8 @@ class QPrinter;
 namespace QComicBook
 {
 	class ImgSink;
+	class SinkOpener;
+	class PageSizeProbe;
 	class ComicBookSettings;
 	class PageViewBase;
 	class ThumbnailsWindow;
@@ -50,6 +52,10 @@ namespace QComicBook
 
 		private:
 			QSharedPointer<ImgSink> sink;
+			QPointer<SinkOpener> opener; //!< open in progress
+			QPointer<SinkOpener> preopener; //!< speculative open of the next or previous volume in progress
+			QSharedPointer<ImgSink> presink; //!< speculatively opened next or previous volume
+			QPointer<PageSizeProbe> probe; //!< finds dimensions of pages for continuous view
 			QPointer<PageViewBase> view;
 			QPointer<ThumbnailsWindow> thumbswin;
 			QSharedPointer<Bookmarks> bookmarks;
@@ -82,6 +88,12 @@ namespace QComicBook
 
 			bool confirmExit();
 			void enableComicBookActions(bool f=true);
+			void attachSink(const QSharedPointer<ImgSink> &s);
+			int decodeSize() const;
+			void updateDecodeSize();
+			void probePageSizes();
+			void preopen(const QString &path);
+			void cancelPreopen();
 			void saveSettings();
 
 			void setupContextMenu();
@@ -91,7 +103,12 @@ namespace QComicBook
 		protected slots:
 			void pageLoaded(const Page &page);
 			void pageLoaded(const Page &page1, const Page &page2);
+			void sinkOpened(int status);
+			void sinkPreopened(int status);
 			void sinkReady(const QString &path);
+			void sinkPageChanged(int page);
+			void sinkPagesAdded(int total);
+			void pageSizesProbed(int first, const QList<QSize> &sizes);
 			void sinkError(int code);
 			void updateCaption();
 			void recentSelected(const QString &fname);
@@ -42,7 +42,7 @@ ComicPageImage::~ComicPageImage()
 
 QSize ComicPageImage::estimatedSize() const
 {
-    return estimated ? pageSize : getScaledSize();
+    return isEstimated() ? pageSize : getScaledSize();
 }
 
 void ComicPageImage::deletePages()
@@ -95,7 +95,7 @@ bool ComicPageImage::isDisposed() const
 
 void ComicPageImage::setEstimatedSize(int w, int h)
 {
-    if (estimated) // update size only if we have estimated size, otherwise we know last real size
+    if (isEstimated()) // update size only if we have estimated size, otherwise we know real size
     {
         if (pageSize.width() != w || pageSize.height() != h)
         {
@@ -105,9 +105,18 @@ void ComicPageImage::setEstimatedSize(int w, int h)
     }
 }
 
+void ComicPageImage::setKnownSize(const QSize &s)
+{
+    if (knownSize != s)
+    {
+        knownSize = s;
+        redrawImages();
+    }
+}
+
 bool ComicPageImage::isEstimated() const
 {
-    return estimated;
+    return estimated && !knownSize.isValid();
 }
 
 int ComicPageImage::pageNumber() const
@@ -162,10 +171,11 @@ void ComicPageImage::redrawImages()
     int totalWidth, totalHeight;
     ViewProperties &props = view()->properties();
 
-    if (pages == 0) // images not set or disposed, use last known or estimated size
+    if (pages == 0) // images not set or disposed, use probed, last known or estimated size
     {
-        totalWidth = pageSize.width();
-        totalHeight = pageSize.height();
+        const QSize s(knownSize.isValid() ? knownSize : pageSize);
+        totalWidth = s.width();
+        totalHeight = s.height();
     }
     else if (pages == 1)
     {
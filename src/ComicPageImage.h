@@ -37,6 +37,8 @@ namespace QComicBook
 
         void redrawImages();
         void setEstimatedSize(int w, int h);
+        //! Sets size of 1 or 2 pages found without loading them; used instead of estimated size.
+        void setKnownSize(const QSize &s);
         bool isEstimated() const;
         int pageNumber() const;
         bool hasTwoPages() const;
@@ -53,6 +55,7 @@ namespace QComicBook
         int m_pageNum; //number of physical page
         Page *m_image[2];
         QSize pageSize; //size of 1 or 2 pages without scaling
+        QSize knownSize; //probed size of 1 or 2 pages without scaling; invalid if not known
         bool estimated;
         bool m_twoPages; //whether this widget holds one or two pages; this is independent from current two pages mode setting
 
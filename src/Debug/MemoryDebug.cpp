@@ -12,6 +12,8 @@
 
 #include "MemoryDebug.h"
 #include "ComicImage.h"
+#include "Sink/BulkStore.h"
+#include "Sink/ImgSink.h"
  
 namespace QComicBook
 {
@@ -40,6 +42,11 @@ void MemoryDebug::refresh()
     debug_text->clear();
     appendObjectCount("ComicImage", Counted<ComicImage>::objectCount(), Counted<ComicImage>::objectTotal());
     appendObjectCount("ImageTransformJob", Counted<ImageTransformJob>::objectCount(), Counted<ImageTransformJob>::objectTotal());
+
+    const BulkStore &store(BulkStore::instance());
+    debug_text->appendPlainText(QString("BulkStore\t%1 files\t %2 / %3 KB").arg(QString::number(store.count()), QString::number(store.size() / 1024), QString::number(store.maxSize() / 1024)));
+    debug_text->appendPlainText(QString("Shared page loads\t%1").arg(ImgSink::sharedLoads()));
+    debug_text->appendPlainText(QString("Cancelled page loads\t%1 of %2").arg(QString::number(ImgSink::cancelledLoads()), QString::number(ImgSink::cancellableLoads())));
 }
 
 void MemoryDebug::appendObjectCount(const QString &className, int count, int total)
@@ -10,9 +10,149 @@
  * WITHOUT ANY WARRANTY. See GPL for more details.
  */
 
-#include <algorithm>
 #include "DirReader.h"
 #include "NaturalComparator.h"
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QRunnable>
+#include <sys/types.h>
+#include <dirent.h>
+
+namespace
+{
+	struct DirEntry
+	{
+		QString name;
+		bool dir;
+	};
+
+	//
+	// lists directory without stat'ing its entries where possible
+	QList<DirEntry> readDir(const QString &path)
+	{
+		QList<DirEntry> entries;
+		DIR *d = opendir(QFile::encodeName(path).constData());
+		if (!d)
+			return entries;
+		QStringList names;
+		QSet<QString> dirs;
+		struct dirent *de;
+		while ((de = readdir(d)) != NULL)
+		{
+			if (de->d_name[0] == '.') //., .. and hidden files
+				continue;
+			const QString name(QFile::decodeName(de->d_name));
+#ifdef _DIRENT_HAVE_D_TYPE
+			if (de->d_type == DT_DIR || de->d_type == DT_REG)
+			{
+				names.append(name);
+				if (de->d_type == DT_DIR)
+					dirs.insert(name);
+				continue;
+			}
+#endif
+			//
+			// symlink or type not reported by filesystem
+			const QFileInfo finfo(path + "/" + name);
+			if (finfo.isDir() || finfo.isFile())
+			{
+				names.append(name);
+				if (finfo.isDir())
+					dirs.insert(name);
+			}
+		}
+		closedir(d);
+
+		naturalSort(names);
+		foreach (const QString &name, names)
+		{
+			DirEntry e;
+			e.name = name;
+			e.dir = dirs.contains(name);
+			entries.append(e);
+		}
+		return entries;
+	}
+}
+
+//
+// lists directories in a thread pool, ahead of the visit
+class DirReader::Prefetcher
+{
+	public:
+		Prefetcher()
+		{
+			pool.setMaxThreadCount(4);
+		}
+
+		~Prefetcher()
+		{
+			pool.clear();
+			pool.waitForDone();
+		}
+
+		void request(const QString &path)
+		{
+			QMutexLocker lock(&mtx);
+			if (!listings.contains(path))
+			{
+				listings.insert(path, Listing());
+				pool.start(new Job(this, path));
+			}
+		}
+
+		QList<DirEntry> take(const QString &path)
+		{
+			QMutexLocker lock(&mtx);
+			if (!listings.contains(path))
+			{
+				lock.unlock();
+				return readDir(path);
+			}
+			while (!listings.value(path).done)
+				cond.wait(&mtx);
+			return listings.take(path).entries;
+		}
+
+	private:
+		struct Listing
+		{
+			bool done;
+			QList<DirEntry> entries;
+			Listing(): done(false) {}
+		};
+
+		class Job: public QRunnable
+		{
+			public:
+				Job(Prefetcher *p, const QString &path): prefetcher(p), path(path) {}
+
+				virtual void run()
+				{
+					const QList<DirEntry> entries = readDir(path);
+					QMutexLocker lock(&prefetcher->mtx);
+					Listing &l = prefetcher->listings[path];
+					l.entries = entries;
+					l.done = true;
+					prefetcher->cond.wakeAll();
+				}
+
+			private:
+				Prefetcher *prefetcher;
+				const QString path;
+		};
+
+		QThreadPool pool;
+		QMutex mtx;
+		QWaitCondition cond;
+		QMap<QString, Listing> listings;
+};
 
 DirReader::DirReader(QDir::SortFlags sortFlags, int maxDepth): flags(sortFlags), maxDirDepth(maxDepth)
 {
@@ -22,31 +162,44 @@ DirReader::~DirReader()
 {
 }
 
-void DirReader::recurseDir(const QString &path, int curDepth)
+void DirReader::recurseDir(Prefetcher &prefetcher, const QString &path, int curDepth)
 {
-	QDir dir(path);
-	dir.setSorting(flags);
-	dir.setFilter(QDir::AllDirs|QDir::Files);
-	QStringList files = dir.entryList();
-	std::sort(files.begin(), files.end(), NaturalComparator());
+	const QList<DirEntry> entries = prefetcher.take(path);
+	if (curDepth < maxDirDepth)
+	{
+		foreach (const DirEntry &e, entries)
+		{
+			if (e.dir)
+				prefetcher.request(path + "/" + e.name);
+		}
+	}
 
-	foreach (QString f, files)
+	foreach (const DirEntry &e, entries)
         {
-            if (f == "." || f == "..") //FIXME: use no-dot and no-dot-dot filter
-                continue;
-            QFileInfo finf(dir, f);
-            fileHandler(finf);
-            if (finf.isDir()) // && (finf.absoluteFilePath() != path))
+            if (visitCancelled())
+                return;
+            const QString fullname(path + "/" + e.name);
+            fileHandler(QFileInfo(fullname));
+            if (e.dir && curDepth < maxDirDepth)
             {
-                if (curDepth < maxDirDepth)
-                {
-                    recurseDir(finf.absoluteFilePath(), curDepth+1);
-                }
+                batchDone();
+                recurseDir(prefetcher, fullname, curDepth+1);
             }
 	}
+	batchDone();
+}
+
+bool DirReader::visitCancelled() const
+{
+	return false;
+}
+
+void DirReader::batchDone()
+{
 }
 
 void DirReader::visit(const QString &path)
 {
-	recurseDir(path, 0);
+	Prefetcher prefetcher;
+	recurseDir(prefetcher, path, 0);
 }
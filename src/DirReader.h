@@ -16,16 +16,28 @@
 #include <QDir>
 #include <QFileInfo>
 
+//! Visits files of a directory tree in natural order of names.
+/*! Directories are listed with readdir(); file types come from d_type, so files are
+ *  not stat'ed unless the filesystem doesn't report types. Subdirectories are listed
+ *  ahead in a thread pool while the files of their parent are being handled. */
 class DirReader
 {
 	private:
+		class Prefetcher;
+
 		QDir::SortFlags flags;
 		int maxDirDepth;
 
-		void recurseDir(const QString &path, int curDepth);
+		void recurseDir(Prefetcher &prefetcher, const QString &path, int curDepth);
 		
 	protected:
 		virtual bool fileHandler(const QFileInfo &path) = 0;
+		//! Returns true if visit() should stop; checked before each file.
+		virtual bool visitCancelled() const;
+		//! Called when files visited so far follow all the files visited later.
+		/*! That is before descending into a subdirectory and after the last file of
+		 *  a directory; readers may publish files handled so far then. */
+		virtual void batchDone();
 
 	public:
 		DirReader(QDir::SortFlags sortFlags, int maxDepth);
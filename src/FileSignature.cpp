@@ -11,6 +11,7 @@
  */
 
 #include "FileSignature.h"
+#include <string.h>
 
 using namespace QComicBook;
 
@@ -37,19 +38,13 @@ FileSignature::~FileSignature()
 
 bool FileSignature::matches(QFile *file) const
 {
-    if (pattern.size() > 0 && file->seek(offset))
-    {
-        for (int i=0; i<pattern.size(); i++)
-        {
-            char c;
-            if (!file->getChar(&c))
-                return false;
-            if (c != pattern.at(i))
-                return false;
-        }
-        return true;
-    }
-    return false;
+    return pattern.size() > 0 && file->seek(offset) && file->read(pattern.size()) == pattern;
+}
+
+bool FileSignature::matches(const QByteArray &head) const
+{
+    return pattern.size() > 0 && static_cast<unsigned int>(head.size()) >= offset + pattern.size()
+        && memcmp(head.constData() + offset, pattern.constData(), pattern.size()) == 0;
 }
 
 FileSignature& FileSignature::operator =(const FileSignature &sig)
@@ -27,6 +27,8 @@ namespace QComicBook
         ~FileSignature();
 
         bool matches(QFile *file) const;
+        //! Matches leading bytes of a file, see FileTypeDetector::readHead().
+        bool matches(const QByteArray &head) const;
         FileSignature& operator =(const FileSignature &sig);
 
     private:
@@ -0,0 +1,91 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "FileTypeDetector.h"
+#include "ImageFormatsInfo.h"
+#include "Archivers/ArchiversConfiguration.h"
+#include <QFile>
+#include <string.h>
+
+using namespace QComicBook;
+
+const int FileTypeDetector::HEAD_SIZE = 4096;
+
+namespace
+{
+    struct SignatureEntry
+    {
+        unsigned int offset;
+        const char *pattern;
+        unsigned int len;
+        FileTypeDetector::FileType type;
+    };
+
+    //
+    // archive signatures are matched by ArchiversConfiguration
+    const SignatureEntry signatures[] = {
+        {0, "\xff\xd8\xff", 3, FileTypeDetector::ImageFile},
+        {0, "\x89PNG\r\n\x1a\n", 8, FileTypeDetector::ImageFile},
+        {0, "GIF8", 4, FileTypeDetector::ImageFile},
+        {0, "BM", 2, FileTypeDetector::ImageFile},
+        {8, "WEBP", 4, FileTypeDetector::ImageFile},
+        {0, "II*\0", 4, FileTypeDetector::ImageFile},
+        {0, "MM\0*", 4, FileTypeDetector::ImageFile},
+        {0, NULL, 0, FileTypeDetector::UnknownFile}
+    };
+}
+
+QByteArray FileTypeDetector::readHead(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QByteArray head(file.read(HEAD_SIZE));
+    if (head.isNull())
+        head = QByteArray("");
+    return head;
+}
+
+FileTypeDetector::FileType FileTypeDetector::detect(const QString &path)
+{
+    return detect(path, readHead(path));
+}
+
+FileTypeDetector::FileType FileTypeDetector::detect(const QString &name, const QByteArray &head)
+{
+    if (head.startsWith("%PDF-"))
+        return PdfFile;
+
+    for (int i=0; signatures[i].pattern; i++)
+    {
+        const SignatureEntry &s(signatures[i]);
+        if (static_cast<unsigned int>(head.size()) >= s.offset + s.len && memcmp(head.constData() + s.offset, s.pattern, s.len) == 0)
+            return s.type;
+    }
+    if (ArchiversConfiguration::instance().isArchive(name, head))
+        return ArchiveFile;
+
+    //
+    // PDF header may be preceded by up to 1024 bytes of garbage; checked only after
+    // archives, as a PDF stored first in .cbt or .cbz shows up within that range too
+    const int pdf = head.indexOf("%PDF-");
+    if (pdf > 0 && pdf < 1024)
+        return PdfFile;
+
+    //
+    // contents unknown or not readable
+    if (name.endsWith(".pdf", Qt::CaseInsensitive))
+        return PdfFile;
+    if (ImageFormatsInfo::instance().hasSuffix(name.mid(name.lastIndexOf('.') + 1).toLower()))
+        return ImageFile;
+    return UnknownFile;
+}
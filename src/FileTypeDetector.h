@@ -0,0 +1,58 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __FILE_TYPE_DETECTOR_H
+#define __FILE_TYPE_DETECTOR_H
+
+#include <QString>
+#include <QByteArray>
+
+namespace QComicBook
+{
+	/**
+	 * @brief Detects type of file from its contents.
+	 *
+	 * The first HEAD_SIZE bytes of the file are read once and matched against a table of
+	 * signatures; the same head can be passed on to ArchiversConfiguration to pick archiver
+	 * strategy without opening the file again. Extension is used only if contents don't match.
+	 */
+    class FileTypeDetector
+    {
+    public:
+        enum FileType
+        {
+            UnknownFile,
+            ImageFile,
+            PdfFile,
+            ArchiveFile
+        };
+
+        //! Number of leading bytes needed to match all known signatures.
+        static const int HEAD_SIZE;
+
+		/**
+		 * @brief Reads leading bytes of the file.
+		 * @return head of the file; null byte array if file can't be read
+		 */
+        static QByteArray readHead(const QString &path);
+
+        static FileType detect(const QString &path);
+
+		/**
+		 * @brief Detects type from head of the file read with readHead().
+		 * @param name file name, used if head doesn't match any signature
+		 */
+        static FileType detect(const QString &name, const QByteArray &head);
+    };
+}
+
+#endif
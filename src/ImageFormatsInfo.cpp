@@ -37,6 +37,7 @@ ImageFormatsInfo::ImageFormatsInfo()
         {
             m_extensions.append("." + b);
             m_formats.append(QString(b).toUpper());
+            m_suffixes.insert(QString(b));
         }
     }
 }
@@ -55,3 +56,8 @@ QStringList ImageFormatsInfo::formats() const
 {
     return m_formats;
 }
+
+bool ImageFormatsInfo::hasSuffix(const QString &suffix) const
+{
+    return m_suffixes.contains(suffix);
+}
@@ -14,6 +14,7 @@
 #define __IMAGE_FORMATS_INFO_H
 
 #include <QStringList>
+#include <QSet>
 
 namespace QComicBook
 {
@@ -25,6 +26,9 @@ namespace QComicBook
         QStringList extensions() const;
         QStringList formats() const;
 
+        //! Returns true if file name suffix (without dot, lower case) is one of extensions().
+        bool hasSuffix(const QString &suffix) const;
+
     private:
         ImageFormatsInfo();
         ImageFormatsInfo(const ImageFormatsInfo &);
@@ -33,6 +37,7 @@ namespace QComicBook
         static ImageFormatsInfo *sm_info;
         QStringList m_extensions;
         QStringList m_formats;
+        QSet<QString> m_suffixes;
     };
 }
 
@@ -60,3 +60,16 @@ bool ImgCache::get(int num, QImage &img)
 	return status;
 }
 
+void ImgCache::remove(int page)
+{
+	mtx.lock();
+	cache.remove(page);
+	mtx.unlock();
+}
+
+void ImgCache::clear()
+{
+	mtx.lock();
+	cache.clear();
+	mtx.unlock();
+}
@@ -36,6 +36,8 @@ namespace QComicBook
 			virtual void setSize(int size, bool autoAdjust=false);
 			void insertImage(int page, const QImage &img);
 			bool get(int num, QImage &img);
+			void remove(int page);
+			void clear();
 	};
 }
 
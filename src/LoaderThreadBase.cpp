@@ -13,10 +13,24 @@
 #include "LoaderThreadBase.h"
 #include "Sink/ImgSink.h"
 #include <QPixmap>
+#include <QMutexLocker>
 #include "ComicBookDebug.h"
 
 using namespace QComicBook;
-LoaderThreadBase::LoaderThreadBase(): QThread(), prio(QThread::LowPriority), sink(NULL), stopped(false)
+
+const int LoaderThreadBase::MAX_RUN = 4;
+
+LoaderWorker::LoaderWorker(LoaderThreadBase *loader): QThread(), loader(loader)
+{
+}
+
+void LoaderWorker::run()
+{
+    loader->work();
+}
+
+LoaderThreadBase::LoaderThreadBase(int workers, bool ordered): QThread(), prio(QThread::LowPriority), focus(0), sequence(0), sink(NULL), stopped(false),
+    nworkers(qMax(1, workers)), ordered(ordered), tickets(0), delivered(0), generation(0)
 {
 }
 
@@ -24,6 +38,11 @@ LoaderThreadBase::~LoaderThreadBase()
 {
 }
 
+int LoaderThreadBase::workers() const
+{
+    return nworkers;
+}
+
 void LoaderThreadBase::setPriority(QThread::Priority p)
 {
     loaderMutex.lock();
@@ -33,9 +52,158 @@ void LoaderThreadBase::setPriority(QThread::Priority p)
 
 void LoaderThreadBase::setSink(QSharedPointer<ImgSink> sink)
 {
-    sinkMutex.lock();
+    //
+    // results for the old sink are dropped; workers waiting for their turn
+    // to deliver are let go, so they release the sink lock
+    loaderMutex.lock();
+    deferred.clear();
+    helpers.clear();
+    cancelInFlight();
+    ++generation;
+    tickets = delivered = 0;
+    finished.clear();
+    loaderMutex.unlock();
+    deliveryCond.wakeAll();
+
+    sinkLock.lockForWrite();
     this->sink = sink;
-    sinkMutex.unlock();
+    sinkLock.unlock();
+}
+
+bool LoaderThreadBase::isAvailable(const LoadRequest &req) const
+{
+    const int n = sink->availableImages();
+    if (req.pageNumber >= n)
+    {
+        return false;
+    }
+    //
+    // second page of the request may not exist at all
+    return !req.twoPages || req.pageNumber + 1 < n || n == sink->numOfImages();
+}
+
+bool LoaderThreadBase::processRun(const QList<LoadRequest> &reqs)
+{
+    bool status = true;
+    foreach (const LoadRequest &req, reqs)
+    {
+        status &= process(req);
+    }
+    return status;
+}
+
+bool LoaderThreadBase::beginDelivery(const LoadRequest &req)
+{
+    QMutexLocker locker(&loaderMutex);
+    while (ordered && !stopped && req.generation == generation && delivered < req.ticket)
+    {
+        deliveryCond.wait(&loaderMutex);
+    }
+    return !stopped && req.generation == generation;
+}
+
+void LoaderThreadBase::endDelivery(const LoadRequest &req)
+{
+    QMutexLocker locker(&loaderMutex);
+    if (req.generation != generation || req.ticket < delivered)
+    {
+        return;
+    }
+    finished.insert(req.ticket);
+    while (finished.remove(delivered))
+    {
+        ++delivered;
+    }
+    deliveryCond.wakeAll();
+}
+
+bool LoaderThreadBase::QueueKey::operator<(const QueueKey &k) const
+{
+    if (cls != k.cls)
+    {
+        return cls < k.cls;
+    }
+    if (distance != k.distance)
+    {
+        return distance < k.distance;
+    }
+    return seq < k.seq;
+}
+
+int LoaderThreadBase::requestId(const LoadRequest &req)
+{
+    return req.pageNumber * 2 + (req.twoPages ? 1 : 0);
+}
+
+LoaderThreadBase::QueueKey LoaderThreadBase::queueKey(const LoadRequest &req)
+{
+    QueueKey k;
+    k.cls = req.cls;
+    //
+    // user is more likely to move forward, so pages ahead win ties
+    k.distance = 2 * qAbs(req.pageNumber - focus) + (req.pageNumber < focus ? 1 : 0);
+    k.seq = sequence++;
+    return k;
+}
+
+bool LoaderThreadBase::enqueue(const LoadRequest &req)
+{
+    const int id = requestId(req);
+    QHash<int, QueueKey>::iterator it = queued.find(id);
+    if (it != queued.end())
+    {
+        if (it.value().cls <= req.cls)
+        {
+            return false;
+        }
+        //
+        // preloaded page is needed for display now
+        requests.remove(it.value());
+        queued.erase(it);
+    }
+    else if (deferred.contains(req))
+    {
+        return false;
+    }
+    const QueueKey k(queueKey(req));
+    requests.insert(k, req);
+    queued.insert(id, k);
+    return true;
+}
+
+void LoaderThreadBase::dequeue(const LoadRequest &req)
+{
+    QHash<int, QueueKey>::iterator it = queued.find(requestId(req));
+    if (it != queued.end())
+    {
+        requests.remove(it.value());
+        queued.erase(it);
+    }
+}
+
+LoadRequest LoaderThreadBase::takeFirst()
+{
+    QMap<QueueKey, LoadRequest>::iterator it = requests.begin();
+    const LoadRequest req(it.value());
+    requests.erase(it);
+    queued.remove(requestId(req));
+    return req;
+}
+
+void LoaderThreadBase::cancelInFlight(const LoadRequest &req)
+{
+    foreach (const QSharedPointer<CancelToken> &token, inflight.values(requestId(req)))
+    {
+        token->cancel();
+    }
+}
+
+void LoaderThreadBase::cancelInFlight()
+{
+    foreach (const QSharedPointer<CancelToken> &token, inflight)
+    {
+        token->cancel();
+    }
 }
 
 void LoaderThreadBase::request(int page)
@@ -43,16 +211,12 @@ void LoaderThreadBase::request(int page)
     _DEBUG << "requested page" << page;
 
     loaderMutex.lock();
-    const LoadRequest req(page, false);
-    if (requests.contains(req))
+    const bool added = enqueue(LoadRequest(page, false));
+    loaderMutex.unlock();
+    if (added)
     {
-        _DEBUG << "requests queue already has" << page;
-        loaderMutex.unlock();
-        return;
+        reqCond.wakeOne();
     }
-    requests.append(req);
-    loaderMutex.unlock();
-    reqCond.wakeOne();
 }
 
 void LoaderThreadBase::requestTwoPages(int page)
@@ -60,16 +224,38 @@ void LoaderThreadBase::requestTwoPages(int page)
     _DEBUG << "requested 2 pages" << page;
 
     loaderMutex.lock();
-    const LoadRequest req(page, true);
-    if (requests.contains(req))
+    const bool added = enqueue(LoadRequest(page, true));
+    loaderMutex.unlock();
+    if (added)
     {
-        _DEBUG << "requests queue (2 pages) already has" << page;
-        loaderMutex.unlock();
-        return;
+        reqCond.wakeOne();
+    }
+}
+
+void LoaderThreadBase::preload(int page)
+{
+    _DEBUG << "preload page" << page;
+
+    loaderMutex.lock();
+    const bool added = enqueue(LoadRequest(page, false, PreloadRequest));
+    loaderMutex.unlock();
+    if (added)
+    {
+        reqCond.wakeOne();
     }
-    requests.append(req);
+}
+
+void LoaderThreadBase::preloadTwoPages(int page)
+{
+    _DEBUG << "preload 2 pages" << page;
+
+    loaderMutex.lock();
+    const bool added = enqueue(LoadRequest(page, true, PreloadRequest));
     loaderMutex.unlock();
-    reqCond.wakeOne();
+    if (added)
+    {
+        reqCond.wakeOne();
+    }
 }
 
 void LoaderThreadBase::request(int first, int n)
@@ -85,7 +271,9 @@ void LoaderThreadBase::cancel(int page)
     loaderMutex.lock();
     const LoadRequest req(page, false);
     _DEBUG << "page" << page;
-    requests.removeAll(req);
+    dequeue(req);
+    deferred.removeAll(req);
+    cancelInFlight(req);
     loaderMutex.unlock();
 }
 
@@ -94,7 +282,9 @@ void LoaderThreadBase::cancelTwoPages(int page)
     loaderMutex.lock();
     _DEBUG << "2 pages" << page;
     const LoadRequest req(page, true);
-    requests.removeAll(req);
+    dequeue(req);
+    deferred.removeAll(req);
+    cancelInFlight(req);
     loaderMutex.unlock();
 }
 
@@ -103,50 +293,199 @@ void LoaderThreadBase::cancelAll()
     loaderMutex.lock();
     _DEBUG << "all pages";
     requests.clear();
+    queued.clear();
+    deferred.clear();
+    helpers.clear();
+    cancelInFlight();
     loaderMutex.unlock();
 }
 
+void LoaderThreadBase::setFocusPage(int page)
+{
+    loaderMutex.lock();
+    if (page != focus)
+    {
+        focus = page;
+        const QList<LoadRequest> reqs(requests.values());
+        requests.clear();
+        queued.clear();
+        foreach (const LoadRequest &req, reqs)
+        {
+            enqueue(req);
+        }
+    }
+    loaderMutex.unlock();
+}
+
+void LoaderThreadBase::pagesAvailable(int upto)
+{
+    loaderMutex.lock();
+    QList<LoadRequest> ready;
+    for (QList<LoadRequest>::iterator it = deferred.begin(); it != deferred.end(); )
+    {
+        if (it->pageNumber < upto)
+        {
+            ready.append(*it);
+            it = deferred.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    foreach (const LoadRequest &req, ready)
+    {
+        enqueue(req);
+    }
+    loaderMutex.unlock();
+    if (ready.size())
+    {
+        _DEBUG << ready.size() << "deferred requests ready, upto" << upto;
+        reqCond.wakeAll();
+    }
+}
+
 void LoaderThreadBase::stop()
 {
     loaderMutex.lock();
     stopped = true;
     loaderMutex.unlock();
-    reqCond.wakeOne();
+    reqCond.wakeAll();
+    deliveryCond.wakeAll();
 }
 
 void LoaderThreadBase::run()
+{
+    QList<LoaderWorker *> others;
+    for (int i=1; i<nworkers; i++)
+    {
+        LoaderWorker *w = new LoaderWorker(this);
+        w->start(priority());
+        others.append(w);
+    }
+    _DEBUG << nworkers << "workers";
+
+    work();
+
+    foreach (LoaderWorker *w, others)
+    {
+        w->wait();
+        delete w;
+    }
+}
+
+void LoaderThreadBase::work()
 {
     for (;;)
     {
-        condMutex.lock();
-        reqCond.wait(&condMutex);
-        condMutex.unlock();
-        	
-        for (;;) {
-            loaderMutex.lock();
-            if (stopped)
+        loaderMutex.lock();
+        while (!stopped && requests.empty() && helpers.empty())
+        {
+            reqCond.wait(&loaderMutex);
+        }
+        if (stopped)
+        {
+            loaderMutex.unlock();
+            return;
+        }
+
+        if (!helpers.empty())
+        {
+            //
+            // second page of two pages request some other worker is busy with;
+            // the page ends up in sink cache, where that worker picks it up
+            const LoadRequest req(helpers.takeFirst());
+            const bool current = (req.generation == generation);
+            loaderMutex.unlock();
+
+            sinkLock.lockForRead();
+            if (sink && current && !req.token->isCancelled())
             {
-                loaderMutex.unlock();
-                return;
+                _DEBUG << "loading ahead" << req.pageNumber;
+                int result;
+                sink->getImage(req.pageNumber, result, req.token.data());
             }
+            sinkLock.unlock();
+            continue;
+        }
 
-            if (requests.empty())
+        QList<LoadRequest> run;
+        run.append(takeFirst());
+        //
+        // requests for following pages are taken along, so that sink can read them in one go
+        while (!run.first().twoPages && run.size() < MAX_RUN)
+        {
+            const QHash<int, QueueKey>::const_iterator it = queued.constFind(requestId(LoadRequest(run.last().pageNumber + 1, false)));
+            if (it == queued.constEnd())
             {
-                loaderMutex.unlock();
                 break;
             }
-            const LoadRequest req(requests.first());
-            requests.pop_front();
+            run.append(requests.take(it.value()));
+            queued.remove(requestId(run.last()));
+        }
+        for (int i=0; i<run.size(); i++)
+        {
+            run[i].ticket = tickets++;
+            run[i].generation = generation;
+            run[i].token = QSharedPointer<CancelToken>(new CancelToken());
+            inflight.insert(requestId(run[i]), run[i].token);
+        }
+        loaderMutex.unlock();
+
+        sinkLock.lockForRead();
+        if (sink)
+        {
+            //
+            // pages not extracted yet are put aside until sink announces them;
+            // availability is checked under loaderMutex so that pagesAvailable() can't be missed
+            QList<LoadRequest> ready;
+            loaderMutex.lock();
+            foreach (const LoadRequest &req, run)
+            {
+                if (isAvailable(req))
+                {
+                    ready.append(req);
+                }
+                else
+                {
+                    _DEBUG << "deferring" << req.pageNumber;
+                    deferred.append(req);
+                }
+            }
+            //
+            // both pages of two pages request are decoded at once by two workers
+            if (ready.size() == 1 && ready.first().twoPages && nworkers > 1 && ready.first().pageNumber + 1 < sink->numOfImages())
+            {
+                LoadRequest helper(ready.first().pageNumber + 1, false);
+                helper.generation = generation;
+                helper.token = ready.first().token; //cancelled along with the request
+                helpers.append(helper);
+                reqCond.wakeOne();
+            }
             loaderMutex.unlock();
 
-            sinkMutex.lock(); //TODO is it safe to lock when process() may emit signal?
-            if (sink)
+            if (ready.size() == 1)
+            {
+                _DEBUG << "loading" << ready.first().pageNumber;
+                process(ready.first());
+            }
+            else if (ready.size() > 1)
             {
-                _DEBUG << "loading" << req.pageNumber;
-                process(req);
+                _DEBUG << "loading" << ready.size() << "pages from" << ready.first().pageNumber;
+                processRun(ready);
             }
-            sinkMutex.unlock();
-	}
+        }
+        sinkLock.unlock();
+
+        foreach (const LoadRequest &req, run)
+        {
+            endDelivery(req);
+        }
+        loaderMutex.lock();
+        foreach (const LoadRequest &req, run)
+        {
+            inflight.remove(requestId(req), req.token);
+        }
+        loaderMutex.unlock();
     }
 }
-
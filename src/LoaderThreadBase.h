@@ -15,54 +15,160 @@
 
 #include <QThread>
 #include <QList>
+#include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QMutex>
+#include <QReadWriteLock>
 #include <QWaitCondition>
 #include <QSharedPointer>
 #include "Sink/ImgSink.h"
+#include "Sink/CancelToken.h"
 
 namespace QComicBook
 {
     class Page;
     
+    //! Classes of requests; lower go first.
+    enum RequestClass
+    {
+        VisibleRequest, //!< page the user is waiting for
+        PreloadRequest  //!< page likely to be shown next
+    };
+
     struct LoadRequest
     {
         int pageNumber;
         bool twoPages;
+        RequestClass cls;
+        int ticket; //!< order in which the request was taken by a worker; see LoaderThreadBase::beginDelivery()
+        int generation; //!< sink the request was taken for; see LoaderThreadBase::setSink()
+        QSharedPointer<CancelToken> token; //!< cancelled when the request is no longer needed while being loaded
         
-        LoadRequest(int page, bool twoPages): pageNumber(page), twoPages(twoPages) {}
+        LoadRequest(int page, bool twoPages, RequestClass cls=VisibleRequest): pageNumber(page), twoPages(twoPages), cls(cls), ticket(-1), generation(-1) {}
         bool operator==(const LoadRequest &r)
         {
             return pageNumber == r.pageNumber && twoPages == r.twoPages;
         }
     };
+
+    class LoaderThreadBase;
+
+    //! Additional worker of LoaderThreadBase.
+    class LoaderWorker: public QThread
+    {
+        public:
+            LoaderWorker(LoaderThreadBase *loader);
+
+        protected:
+            virtual void run();
+
+        private:
+            LoaderThreadBase *loader;
+    };
     
     class LoaderThreadBase: public QThread
     {
             Q_OBJECT
 
+            friend class LoaderWorker;
+
             protected:
                 volatile QThread::Priority prio; //!<thread priority
-                QList<LoadRequest> requests; //!<the list of requested pages
+                //! Position of a request in the queue.
+                struct QueueKey
+                {
+                    int cls; //!<class of the request
+                    int distance; //!<distance from focus page; pages ahead go before pages behind
+                    int seq; //!<keeps order of equal requests
+
+                    bool operator<(const QueueKey &k) const;
+                };
+
+                QMap<QueueKey, LoadRequest> requests; //!<requested pages, most urgent first
+                QHash<int, QueueKey> queued; //!<keys of requests, by requestId()
+                int focus; //!<page the user is looking at
+                int sequence; //!<counter for QueueKey::seq
+                QList<LoadRequest> deferred; //!<requested pages which are not available in the sink yet
+                QList<LoadRequest> helpers; //!<second pages of two pages requests, loaded ahead by idle workers
                 QSharedPointer<ImgSink> sink;
                 QMutex loaderMutex;
-                QMutex condMutex;
-                QMutex sinkMutex;
-                QWaitCondition reqCond;
+                QReadWriteLock sinkLock; //!<held for reading by workers while they process requests
+                QWaitCondition reqCond; //!<signaled when requests are added or loader is stopped
+                QWaitCondition deliveryCond; //!<signaled when a request is delivered
                 volatile bool stopped;
+                int nworkers; //!<number of threads loading pages, including this one
+                bool ordered; //!<results are delivered in the order requests were taken
+                int tickets; //!<ticket of the next request taken
+                int delivered; //!<requests with lower tickets are delivered
+                QSet<int> finished; //!<delivered tickets greater than delivered
+                int generation; //!<incremented by setSink()
+                QMultiHash<int, QSharedPointer<CancelToken> > inflight; //!<tokens of requests being loaded, by requestId()
 
                 //! Main function of the thread.
-                /*! Preloads requested pages from requests list using sink->getImage().
-                 *  Stop if stopped flag is true.
-                 *  @see ImgDirSink::getImage
+                /*! Starts additional workers and loads pages along with them.
+                 *  @see work
                  */
                 virtual void run();
 
+                //! Takes requests from the queue and processes them until stopped.
+                /*! Runs in every worker. The queue is shared, so an idle worker picks up whatever
+                 *  is next, including second pages of two pages requests other workers are busy with.
+                 */
+                void work();
+
+                //! Loads pages of the request and delivers them with beginDelivery() and endDelivery().
                 virtual bool process(const LoadRequest &req) = 0;
 
+                //! Processes run of single page requests for consecutive pages.
+                /*! Default implementation calls process() for each of them; loaders
+                 *  override it to fetch the pages with one ImgSink::getImages() call. */
+                virtual bool processRun(const QList<LoadRequest> &reqs);
+
+                //! Maximum number of requests coalesced into a run.
+                static const int MAX_RUN;
+
+                static int requestId(const LoadRequest &req);
+                QueueKey queueKey(const LoadRequest &req);
+
+                //! Queues the request or raises class of the queued one; has to be called with loaderMutex locked.
+                /*! @return false if the request is already queued or deferred */
+                bool enqueue(const LoadRequest &req);
+
+                //! Removes the request from the queue; has to be called with loaderMutex locked.
+                void dequeue(const LoadRequest &req);
+
+                //! Takes the most urgent request; has to be called with loaderMutex locked.
+                LoadRequest takeFirst();
+
+                //! Cancels loads of the request in progress; has to be called with loaderMutex locked.
+                void cancelInFlight(const LoadRequest &req);
+
+                //! Cancels all loads in progress; has to be called with loaderMutex locked.
+                void cancelInFlight();
+
+                //! Checks if all pages of the request can be read from the sink.
+                /*! Has to be called with sinkLock locked. */
+                bool isAvailable(const LoadRequest &req) const;
+
+                //! Waits until all requests taken before this one are delivered, if loader is ordered.
+                /*! @return false if the result must not be delivered (sink was changed or loader stopped) */
+                bool beginDelivery(const LoadRequest &req);
+
+                //! Marks the request as delivered, letting following ones through.
+                /*! Called by the loader for every processed request as well, so it's fine
+                 *  to skip it for requests that failed. */
+                void endDelivery(const LoadRequest &req);
+
            public:
-                LoaderThreadBase();
+                //! Creates loader with given number of threads loading pages.
+                /*! @param workers number of threads, including the loader thread itself
+                 *  @param ordered if true, results are delivered in the order requests were taken */
+                LoaderThreadBase(int workers=1, bool ordered=false);
                 virtual ~LoaderThreadBase();
 
+                int workers() const;
+
                 //! Changes priority of the loader thread.
                 /*! @param p new priority
                  */
@@ -84,6 +190,10 @@ namespace QComicBook
                 virtual void request(int page);
                 
                 virtual void requestTwoPages(int page);
+
+                //! Like request(), but the page goes after pages requested for display.
+                virtual void preload(int page);
+                virtual void preloadTwoPages(int page);
                 
                 //! Appends few pages to the list of pages to load.
                 /*! @param first starting page
@@ -94,6 +204,14 @@ namespace QComicBook
                 virtual void cancel(int page);
                 virtual void cancelTwoPages(int page);
                 virtual void cancelAll();
+
+                //! Sets page the user is looking at; queued requests are reordered by distance from it.
+                virtual void setFocusPage(int page);
+
+                //! Requeues deferred requests for pages that became available.
+                /*! @param upto number of leading pages available in the sink
+                 *  @see ImgSink::pagesAvailable */
+                virtual void pagesAvailable(int upto);
     };
 }
 
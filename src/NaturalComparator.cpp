@@ -11,57 +11,71 @@
  */
 
 #include <QString>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
 #include "NaturalComparator.h"
 
-static unsigned toInt(QString const& s, int *idx)
+//
+// Key is a sequence of tokens followed by a terminator and the length of the string:
+//   digit run:  0x01, number of significant digits (2 bytes), digit values (leading zeros stripped)
+//   other char: 0x02, UTF-16 code unit (2 bytes)
+//   terminator: 0x00, string length (4 bytes)
+// all numbers big-endian. A number with more significant digits is greater and digits go before
+// letters, like in Dave Koelle's Alphanum (http://www.davekoelle.com/alphanum.html).
+QByteArray NaturalComparator::sortKey(QString const& s)
 {
-	int res = 0;
-	int i = *idx;
-	while (i != s.size() && s[i].isDigit())
+	QByteArray key;
+	key.reserve(3*s.size() + 5);
+	const int n = s.size();
+	for (int i = 0; i < n;)
 	{
-		res *= 10;
-		res += s[i].digitValue();
-		++i;
+		if (s[i].isDigit())
+		{
+			while (i < n && s[i].isDigit() && s[i].digitValue() == 0)
+				++i; // leading zeros
+			const int start = i;
+			while (i < n && s[i].isDigit())
+				++i;
+			const int digits = qMin(i - start, 0xffff);
+			key.append('\x01');
+			key.append(static_cast<char>(digits >> 8));
+			key.append(static_cast<char>(digits & 0xff));
+			for (int j = start; j < start + digits; ++j)
+				key.append(static_cast<char>(s[j].digitValue()));
+		}
+		else
+		{
+			const ushort c = s[i].unicode();
+			key.append('\x02');
+			key.append(static_cast<char>(c >> 8));
+			key.append(static_cast<char>(c & 0xff));
+			++i;
+		}
 	}
-	*idx = i;
-	return res;
+	key.append('\0');
+	key.append(static_cast<char>((n >> 24) & 0xff));
+	key.append(static_cast<char>((n >> 16) & 0xff));
+	key.append(static_cast<char>((n >> 8) & 0xff));
+	key.append(static_cast<char>(n & 0xff));
+	return key;
 }
 
-bool NaturalComparator::cmpLetters(QChar l, QChar r) const
+bool NaturalComparator::operator()(QString const& l, QString const& r) const
 {
-	return this->caseSenitive ? l < r : l.toLower() < r.toLower();
+	return sortKey(l) < sortKey(r);
 }
 
-// Adapted from Dave Koelle's Alphanum (http://www.davekoelle.com/alphanum.html)
-// The idea is to split the string into "chunks" of letters or digits
-bool NaturalComparator::operator()(QString const& l, QString const& r) const
+void naturalSort(QStringList &list)
 {
-	enum Mode { String, Number } mode = String;
-	for (int il = 0, ir = 0; il != l.size() && ir != r.size();)
-	{
-		if (mode == String)
-		{
-			for (; il != l.size() && ir != r.size(); ++il, ++ir)
-			{
-				const bool digitL = l[il].isDigit(), digitR = r[ir].isDigit();
-				if (digitL && digitR)
-				{
-					mode = Number;
-					break;
-				}
-				if (digitL) return true;
-				if (digitR) return false;
-				if (l[il] != r[ir]) return l[il] < r[ir];
-			}		
-		}
-		else
-		{
-			// At least the current character is a digit in both strings
-		    unsigned lNum = toInt(l, &il);
-			unsigned rNum = toInt(r, &ir);
-			if (lNum != rNum) return lNum < rNum;
-			mode = String;
-		}
-	}
-	return l.size() < r.size();
+	QVector<QPair<QByteArray, int> > keys(list.size());
+	for (int i = 0; i < list.size(); ++i)
+		keys[i] = qMakePair(NaturalComparator::sortKey(list.at(i)), i);
+	std::sort(keys.begin(), keys.end());
+
+	QStringList sorted;
+	sorted.reserve(list.size());
+	for (int i = 0; i < keys.size(); ++i)
+		sorted.append(list.at(keys.at(i).second));
+	list = sorted;
 }
@@ -10,17 +10,27 @@
  * WITHOUT ANY WARRANTY. See GPL for more details.
  */
 
+#ifndef __NATURALCOMPARATOR_H
+#define __NATURALCOMPARATOR_H
+
 #include <QString>
+#include <QStringList>
+#include <QByteArray>
 
+//! Orders strings so that runs of digits compare by their numeric value ("page2" < "page10").
 class NaturalComparator
 {
-	private:
-		const bool caseSenitive;
-		bool cmpLetters(QChar l, QChar r) const;
-
 	public:
-		NaturalComparator(bool caseSens = false) : caseSenitive(caseSens)
-		{}
-
 		bool operator()(QString const& l, QString const& r) const;
+
+		//! Returns sort key of the string.
+		/*! Keys compared bytewise (e.g. with QByteArray::operator<) are in natural order, so
+		 *  sorting many strings can tokenize each of them once instead of on every comparison.
+		 *  Keys are prefix-free: concatenated keys of path components order paths component-wise. */
+		static QByteArray sortKey(QString const& s);
 };
+
+//! Sorts the list in natural order using precomputed sort keys.
+void naturalSort(QStringList &list);
+
+#endif
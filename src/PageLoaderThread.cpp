@@ -16,7 +16,7 @@
 
 using namespace QComicBook;
 
-PageLoaderThread::PageLoaderThread(): LoaderThreadBase()
+PageLoaderThread::PageLoaderThread(int workers): LoaderThreadBase(workers, true)
 {
 }
 
@@ -29,14 +29,52 @@ bool PageLoaderThread::process(const LoadRequest &req)
     int result;
     if (req.twoPages)
     {                
-        const Page page1(sink->getImage(req.pageNumber, result));
-        const Page page2(sink->getImage(req.pageNumber+1, result));
-        emit pageLoaded(page1, page2); //TODO errors
+        //
+        // with several workers the second page is decoded by another worker meanwhile
+        // and this call only waits for it; see LoaderThreadBase::work()
+        QList<Page> pages;
+        int result2;
+        pages.append(sink->getImage(req.pageNumber, result, req.token.data()));
+        pages.append(sink->getImage(req.pageNumber + 1, result2, req.token.data()));
+        if (result2 == SINKERR_CANCELLED)
+        {
+            result = result2;
+        }
+        //
+        // cancelled pages are not wanted anymore; nothing to deliver
+        if (result != SINKERR_CANCELLED && beginDelivery(req))
+        {
+            emit pageLoaded(pages.at(0), pages.at(1)); //TODO errors
+        }
+        endDelivery(req);
     }
     else
     {
-        const Page page(sink->getImage(req.pageNumber, result));
-        emit pageLoaded(page);
+        const Page page(sink->getImage(req.pageNumber, result, req.token.data()));
+        if (result != SINKERR_CANCELLED && beginDelivery(req))
+        {
+            emit pageLoaded(page);
+        }
+        endDelivery(req);
+    }
+    return true;
+}
+
+bool PageLoaderThread::processRun(const QList<LoadRequest> &reqs)
+{
+    QList<int> nums, results;
+    foreach (const LoadRequest &req, reqs)
+    {
+        nums.append(req.pageNumber);
+    }
+    const QList<Page> pages(sink->getImages(nums, results));
+    for (int i=0; i<pages.size() && i<reqs.size(); i++)
+    {
+        if (beginDelivery(reqs.at(i)))
+        {
+            emit pageLoaded(pages.at(i));
+        }
+        endDelivery(reqs.at(i));
     }
     return true;
 }
@@ -22,6 +22,7 @@ namespace QComicBook
     class Page;
 
     //! Thread-based image loader.
+    /*! Pages are delivered in the order they were requested, even if loaded by several workers. */
     class PageLoaderThread: public LoaderThreadBase
     {
         Q_OBJECT
@@ -31,11 +32,12 @@ namespace QComicBook
             void pageLoaded(const Page &, const Page &);
         
         public:
-            PageLoaderThread();
+            PageLoaderThread(int workers=1);
             virtual ~PageLoaderThread();
         
         protected:
             virtual bool process(const LoadRequest &req);
+            virtual bool processRun(const QList<LoadRequest> &reqs);
         
     };
 }
@@ -0,0 +1,232 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "BookIndex.h"
+#include "ComicBookSettings.h"
+#include "Utility.h"
+#include "../ComicBookDebug.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+using namespace QComicBook;
+
+const quint32 BookIndex::MAGIC = 0x51434249; // "QCBI"
+const quint32 BookIndex::VERSION = 2;
+
+BookIndex::BookIndex(): size(-1), descset(false), modified(false)
+{
+}
+
+BookIndex::BookIndex(const QString &path): path(path), size(-1), descset(false), modified(false)
+{
+	const QFileInfo finfo(path);
+	size = finfo.size();
+	mtime = finfo.lastModified();
+}
+
+BookIndex::~BookIndex()
+{
+}
+
+QString BookIndex::getFullPath() const
+{
+	return ComicBookSettings::instance().indexDir() + "/" + QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex() + ".idx";
+}
+
+bool BookIndex::load(const QString &readerName)
+{
+	if (path.isEmpty())
+		return false;
+
+	const QString fname(getFullPath());
+	QFile f(fname);
+	if (!f.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream str(&f);
+	str.setVersion(QDataStream::Qt_5_0);
+
+	quint32 magic, version;
+	str >> magic >> version;
+	if (magic != MAGIC || version != VERSION)
+		return false;
+
+	QString p, r;
+	qint64 s;
+	QDateTime t;
+	str >> p >> s >> t >> r;
+	if (p != path || s != size || t != mtime || r != readerName)
+	{
+		_DEBUG << "index of" << path << "is outdated";
+		return false;
+	}
+
+	qint32 n;
+	str >> n;
+	QList<ArchiveEntry> e;
+	for (int i=0; i<n && str.status() == QDataStream::Ok; i++)
+	{
+		ArchiveEntry entry;
+		str >> entry;
+		e.append(entry);
+	}
+
+	QByteArray rd;
+	QList<int> pg, tx;
+	QList<QSize> sz;
+	QStringList d;
+	bool ds;
+	str >> rd >> pg >> tx >> sz >> ds >> d;
+	if (str.status() != QDataStream::Ok || sz.size() != pg.size())
+		return false;
+
+	foreach (int i, pg + tx)
+	{
+		if (i < 0 || i >= e.size())
+			return false;
+	}
+
+	reader = r;
+	entrylist = e;
+	readerdata = rd;
+	pagelist = pg;
+	textlist = tx;
+	sizes = sz;
+	desc = d;
+	descset = ds;
+	modified = false;
+	f.close();
+
+	//
+	// indexes are removed when unused for a long time
+	Utility::touch(fname);
+	return true;
+}
+
+bool BookIndex::save()
+{
+	if (!modified || path.isEmpty())
+		return true;
+
+	QFile f(getFullPath());
+	if (!f.open(QIODevice::WriteOnly|QIODevice::Truncate))
+		return false;
+
+	QDataStream str(&f);
+	str.setVersion(QDataStream::Qt_5_0);
+	str << MAGIC << VERSION;
+	str << path << size << mtime << reader;
+	str << static_cast<qint32>(entrylist.size());
+	foreach (const ArchiveEntry &e, entrylist)
+		str << e;
+	str << readerdata << pagelist << textlist << sizes << descset << desc;
+
+	if (str.status() != QDataStream::Ok)
+	{
+		f.close();
+		f.remove();
+		return false;
+	}
+	modified = false;
+	return true;
+}
+
+bool BookIndex::isEmpty() const
+{
+	return entrylist.isEmpty();
+}
+
+void BookIndex::setEntries(const QString &readerName, const QList<ArchiveEntry> &entries, const QList<int> &pages, const QList<int> &texts, const QByteArray &readerData)
+{
+	reader = readerName;
+	entrylist = entries;
+	readerdata = readerData;
+	pagelist = pages;
+	textlist = texts;
+	sizes.clear();
+	for (int i=0; i<pagelist.size(); i++)
+		sizes.append(QSize());
+	desc.clear();
+	descset = false;
+	modified = true;
+}
+
+const QList<ArchiveEntry>& BookIndex::entries() const
+{
+	return entrylist;
+}
+
+const QByteArray& BookIndex::readerData() const
+{
+	return readerdata;
+}
+
+const QList<int>& BookIndex::pages() const
+{
+	return pagelist;
+}
+
+const QList<int>& BookIndex::textEntries() const
+{
+	return textlist;
+}
+
+void BookIndex::setPageSize(int page, const QSize &s)
+{
+	if (page >= 0 && page < sizes.size() && sizes.at(page) != s)
+	{
+		sizes[page] = s;
+		modified = true;
+	}
+}
+
+QSize BookIndex::pageSize(int page) const
+{
+	return (page >= 0 && page < sizes.size()) ? sizes.at(page) : QSize();
+}
+
+void BookIndex::setDescription(const QStringList &d)
+{
+	desc = d;
+	descset = true;
+	modified = true;
+}
+
+bool BookIndex::hasDescription() const
+{
+	return descset;
+}
+
+const QStringList& BookIndex::description() const
+{
+	return desc;
+}
+
+void BookIndex::removeOld(int days)
+{
+	if (days < 1)
+		return;
+
+	const QDateTime currdate = QDateTime::currentDateTime();
+
+	QDir dir(ComicBookSettings::instance().indexDir(), "*.idx", QDir::Unsorted, QDir::Files|QDir::NoSymLinks);
+	const QStringList files = dir.entryList();
+	foreach (const QString f, files)
+	{
+		const QFileInfo finfo(dir.absoluteFilePath(f));
+		if (finfo.lastModified().daysTo(currdate) > days)
+			dir.remove(f);
+	}
+}
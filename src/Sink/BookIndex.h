@@ -0,0 +1,87 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file BookIndex.h */
+
+#ifndef __BOOKINDEX_H
+#define __BOOKINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSize>
+#include <QDateTime>
+#include <QByteArray>
+#include "../Archivers/ArchiveReader.h"
+
+namespace QComicBook
+{
+	//! Persistent index of comic book archive.
+	/*! Keeps everything that is otherwise computed on every open: the list of archive
+	 *  entries, pages in reading order, dimensions of pages that were already decoded
+	 *  and contents of description files. Index is stored in the cache directory and
+	 *  is valid as long as path, size and modification time of the archive match. */
+	class BookIndex
+	{
+		private:
+			QString path; //!< full path of the archive
+			qint64 size; //!< size of the archive file
+			QDateTime mtime; //!< modification time of the archive file
+			QString reader; //!< name of the archive reader that produced entries
+			QList<ArchiveEntry> entrylist; //!< all entries of the archive
+			QByteArray readerdata; //!< reader specific data, see ArchiveReader::indexData()
+			QList<int> pagelist; //!< entries of images, in reading order
+			QList<int> textlist; //!< entries of .nfo and file_id.diz files
+			QList<QSize> sizes; //!< dimensions of pages; invalid size if not known yet
+			QStringList desc; //!< contents of description files
+			bool descset; //!< true if desc was filled in
+			bool modified; //!< true if index has to be saved
+
+			static const quint32 MAGIC;
+			static const quint32 VERSION;
+
+			QString getFullPath() const;
+
+		public:
+			BookIndex();
+			BookIndex(const QString &path);
+			~BookIndex();
+
+			//! Loads index for the archive passed to the constructor.
+			/*! @param readerName name of the reader that will use the entries
+			 *  @return true if index exists and matches current state of the archive */
+			bool load(const QString &readerName);
+
+			//! Saves index if it was modified since load.
+			bool save();
+
+			bool isEmpty() const;
+
+			void setEntries(const QString &readerName, const QList<ArchiveEntry> &entries, const QList<int> &pages, const QList<int> &texts, const QByteArray &readerData = QByteArray());
+			const QList<ArchiveEntry>& entries() const;
+			const QByteArray& readerData() const;
+			const QList<int>& pages() const;
+			const QList<int>& textEntries() const;
+
+			void setPageSize(int page, const QSize &s);
+			QSize pageSize(int page) const;
+
+			void setDescription(const QStringList &d);
+			bool hasDescription() const;
+			const QStringList& description() const;
+
+			//! Removes indexes not used for given number of days.
+			static void removeOld(int days);
+	};
+}
+
+#endif
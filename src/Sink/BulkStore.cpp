@@ -0,0 +1,83 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "BulkStore.h"
+#include <QMutexLocker>
+
+using namespace QComicBook;
+
+const qint64 BulkStore::DEFAULT_SIZE = 256*1024*1024;
+
+BulkStore& BulkStore::instance()
+{
+    static BulkStore store;
+    return store;
+}
+
+BulkStore::BulkStore()
+{
+    setMaxSize(DEFAULT_SIZE);
+}
+
+BulkStore::~BulkStore()
+{
+}
+
+bool BulkStore::get(const QString &key, QByteArray &data)
+{
+    QMutexLocker lock(&mtx);
+    QByteArray *d = cache.object(key);
+    if (!d)
+        return false;
+    data = *d;
+    return true;
+}
+
+bool BulkStore::insert(const QString &key, const QByteArray &data)
+{
+    //
+    // data may point into a mapping of the archive (QByteArray::fromRawData),
+    // which goes away with the sink while the store doesn't
+    QByteArray *d = new QByteArray(data.constData(), data.size());
+    QMutexLocker lock(&mtx);
+    return cache.insert(key, d, d->size() / 1024 + 1);
+}
+
+void BulkStore::remove(const QString &key)
+{
+    QMutexLocker lock(&mtx);
+    cache.remove(key);
+}
+
+void BulkStore::setMaxSize(qint64 bytes)
+{
+    QMutexLocker lock(&mtx);
+    cache.setMaxCost(static_cast<int>(bytes / 1024));
+}
+
+qint64 BulkStore::maxSize() const
+{
+    QMutexLocker lock(&mtx);
+    return static_cast<qint64>(cache.maxCost()) * 1024;
+}
+
+qint64 BulkStore::size() const
+{
+    QMutexLocker lock(&mtx);
+    return static_cast<qint64>(cache.totalCost()) * 1024;
+}
+
+int BulkStore::count() const
+{
+    QMutexLocker lock(&mtx);
+    return cache.count();
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __BULK_STORE_H
+#define __BULK_STORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+
+namespace QComicBook
+{
+	/**
+	 * @brief Process-wide LRU of undecoded page files read in bulk from slow media.
+	 *
+	 * Sinks in bulk read mode (see ImgSink::setBulkRead()) read all pages of the book in one
+	 * sequential pass when it is opened and decode pages from here afterwards. Data is kept
+	 * compressed, as stored in the file or archive; least recently used entries are evicted
+	 * when total size exceeds the limit. Sinks remove their entries when closed.
+	 */
+    class BulkStore
+    {
+    public:
+        static BulkStore& instance();
+
+		/**
+		 * @brief Returns data stored under given key.
+		 * @return false if there is no such entry
+		 */
+        bool get(const QString &key, QByteArray &data);
+
+        //! Stores data under the key, evicting least recently used entries if over the limit.
+        /*! @return false if data alone exceeds the limit */
+        bool insert(const QString &key, const QByteArray &data);
+
+        void remove(const QString &key);
+
+        void setMaxSize(qint64 bytes);
+        qint64 maxSize() const;
+        qint64 size() const;
+        int count() const;
+
+    private:
+        BulkStore();
+        ~BulkStore();
+
+        static const qint64 DEFAULT_SIZE;
+
+        mutable QMutex mtx;
+        QCache<QString, QByteArray> cache; //!< costs are in kilobytes
+    };
+}
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "CancelToken.h"
+
+using namespace QComicBook;
+
+CancelToken::CancelToken()
+{
+}
+
+void CancelToken::cancel()
+{
+	cancelled.storeRelease(1);
+}
+
+bool CancelToken::isCancelled() const
+{
+	return cancelled.loadAcquire() != 0;
+}
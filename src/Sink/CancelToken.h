@@ -0,0 +1,39 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file CancelToken.h */
+
+#ifndef __CANCELTOKEN_H
+#define __CANCELTOKEN_H
+
+#include <QAtomicInt>
+
+namespace QComicBook
+{
+	//! Flag for cooperative cancellation of a page load.
+	/*! The loader keeps the token while the page is being loaded and cancels it when the
+	 *  page is not needed anymore; the sink checks it while reading the image. */
+	class CancelToken
+	{
+		private:
+			QAtomicInt cancelled;
+
+		public:
+			CancelToken();
+
+			//! Requests the load to stop; may be called from any thread.
+			void cancel();
+			bool isCancelled() const;
+	};
+}
+
+#endif
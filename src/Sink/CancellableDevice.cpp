@@ -0,0 +1,57 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "CancellableDevice.h"
+#include "CancelToken.h"
+
+using namespace QComicBook;
+
+CancellableDevice::CancellableDevice(QIODevice *source, const CancelToken *token): QIODevice(), source(source), token(token)
+{
+	//
+	// unbuffered, so that position of source always matches ours
+	open(QIODevice::ReadOnly|QIODevice::Unbuffered);
+}
+
+CancellableDevice::~CancellableDevice()
+{
+}
+
+bool CancellableDevice::isSequential() const
+{
+	return source->isSequential();
+}
+
+qint64 CancellableDevice::size() const
+{
+	return source->size();
+}
+
+bool CancellableDevice::seek(qint64 pos)
+{
+	return source->seek(pos) && QIODevice::seek(pos);
+}
+
+qint64 CancellableDevice::readData(char *data, qint64 maxSize)
+{
+	if (token && token->isCancelled())
+	{
+		setErrorString("Cancelled");
+		return -1;
+	}
+	return source->read(data, maxSize);
+}
+
+qint64 CancellableDevice::writeData(const char *data, qint64 maxSize)
+{
+	return -1;
+}
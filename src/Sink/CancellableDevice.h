@@ -0,0 +1,50 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file CancellableDevice.h */
+
+#ifndef __CANCELLABLEDEVICE_H
+#define __CANCELLABLEDEVICE_H
+
+#include <QIODevice>
+
+namespace QComicBook
+{
+	class CancelToken;
+
+	//! Read-only view of another device that fails reading once the token is cancelled.
+	/*! Image decoders read their input in small chunks as they go, so QImageReader
+	 *  reading from this device gives up within one chunk of data after cancel. */
+	class CancellableDevice: public QIODevice
+	{
+		private:
+			QIODevice *source;
+			const CancelToken *token;
+
+		public:
+			//! Creates device reading from the current position of source.
+			/*! @param source opened device to read from, positioned at its start; not owned
+			 *  @param token token to check before every read; may be NULL */
+			CancellableDevice(QIODevice *source, const CancelToken *token);
+			virtual ~CancellableDevice();
+
+			virtual bool isSequential() const;
+			virtual qint64 size() const;
+			virtual bool seek(qint64 pos);
+
+		protected:
+			virtual qint64 readData(char *data, qint64 maxSize);
+			virtual qint64 writeData(const char *data, qint64 maxSize);
+	};
+}
+
+#endif
@@ -11,17 +11,33 @@
  */
 
 #include "ImgArchiveSink.h"
+#include "BulkStore.h"
+#include "CancelToken.h"
+#include "CancellableDevice.h"
+#include "FileTypeDetector.h"
 #include "Utility.h"
 #include "Archivers/ArchiversConfiguration.h"
+#include "Archivers/ArchiveReader.h"
+#include "Archivers/NestedArchiveReader.h"
 #include "ComicBookSettings.h"
+#include "SinkReaper.h"
+#include "NaturalComparator.h"
+#include "ComicBookDebug.h"
 #include <QStringList>
 #include <QProcess>
 #include <QTextStream>
 #include <QFileInfo>
 #include <QFile>
 #include <QRegExp>
-#include <QApplication>
 #include <QDir>
+#include <QBuffer>
+#include <QImage>
+#include <QImageReader>
+#include <QTextStream>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QSet>
+#include <algorithm>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -31,6 +47,35 @@
 using namespace QComicBook;
 using Utility::which;
 
+namespace
+{
+	//! Orders archive entries (given by index of entry name) the same way DirReader visits extracted archive.
+	/*! Sort keys of paths are built once; keys of components are prefix-free, so concatenated
+	 *  keys compare component by component. */
+	class EntryPathComparator
+	{
+		private:
+			QList<QByteArray> keys;
+
+		public:
+			EntryPathComparator(const QStringList &names)
+			{
+				foreach (const QString &name, names)
+				{
+					QByteArray key;
+					foreach (const QString &part, name.split('/', QString::SkipEmptyParts))
+						key.append(NaturalComparator::sortKey(part));
+					keys.append(key);
+				}
+			}
+
+			bool operator()(int l, int r) const
+			{
+				return keys.at(l) < keys.at(r);
+			}
+	};
+}
+
 ImgArchiveSink::ImgArchiveSink(): ImgDirSink()
 {
 	init();
@@ -52,6 +97,186 @@ ImgArchiveSink::~ImgArchiveSink()
 	ImgArchiveSink::close();
 }
 
+bool ImgArchiveSink::knownArchiveExtension(const QString &path)
+{
+	foreach (const QString ext, ArchiversConfiguration::instance().supportedOpenExtensions())
+	{
+		if (path.endsWith(ext.mid(1), Qt::CaseInsensitive)) //skip leading '*'
+			return true;
+	}
+	return false;
+}
+
+bool ImgArchiveSink::classifyEntries(const QList<ArchiveEntry> &entries, QList<int> &pages, QList<int> &texts, QStringList &names)
+{
+	for (int i=0; i<entries.size(); i++)
+	{
+		const QString fname(entries.at(i).name);
+		names.append(fname);
+		const QString basename(fname.section('/', -1));
+		if (knownImageExtension(fname))
+			pages.append(i);
+		else if (basename.endsWith(".nfo", Qt::CaseInsensitive) || basename == "file_id.diz")
+			texts.append(i);
+		else if (knownArchiveExtension(fname))
+			return false;
+	}
+	return true;
+}
+
+bool ImgArchiveSink::openReader(const QString &path, const QByteArray &head)
+{
+	QSharedPointer<ArchiveReader> r(ArchiversConfiguration::instance().createReader(path, head));
+	if (!r)
+		return false;
+
+	//
+	// index from previous open spares scanning and sorting the archive
+	BookIndex idx(path);
+	QSharedPointer<ArchiveReader> nested(new NestedArchiveReader(r));
+	QSharedPointer<ArchiveReader> ir;
+	if (idx.load(r->name()))
+		ir = r;
+	else if (idx.load(nested->name()))
+		ir = nested;
+	if (ir && ir->reopen(path, idx.entries(), idx.readerData()))
+	{
+		_DEBUG << "using index of" << path;
+		QMutexLocker lock(&readermtx);
+		reader = ir;
+		pageEntries = idx.pages();
+		textEntries = idx.textEntries();
+		readerdesc = idx.description();
+		bookindex = idx;
+		return true;
+	}
+	if (!r->open(path))
+		return false;
+
+	QList<int> pages, texts;
+	QStringList names;
+	if (!classifyEntries(r->entries(), pages, texts, names))
+	{
+		//
+		// archives inside archive are mounted in memory if they can be read in-process
+		if (!nested->open(path))
+		{
+			_DEBUG << "nested archives found, falling back to extraction";
+			return false;
+		}
+		r = nested;
+		pages.clear();
+		texts.clear();
+		names.clear();
+		classifyEntries(r->entries(), pages, texts, names);
+	}
+	const QList<ArchiveEntry> &entries(r->entries());
+	std::sort(pages.begin(), pages.end(), EntryPathComparator(names));
+	idx.setEntries(r->name(), entries, pages, texts, r->indexData());
+	idx.save();
+
+	QMutexLocker lock(&readermtx);
+	reader = r;
+	pageEntries = pages;
+	textEntries = texts;
+	readerdesc.clear();
+	bookindex = idx;
+	return true;
+}
+
+bool ImgArchiveSink::publishEntries(const QString &destdir, const QRegExp &listpattern)
+{
+	QRegExp rx(listpattern);
+	QStringList names;
+	QSet<QString> dirnames;
+	foreach (const QString line, QString::fromLocal8Bit(listing).split('\n', QString::SkipEmptyParts))
+	{
+		if (rx.indexIn(line) < 0)
+			continue;
+		const QString fname(rx.cap(1));
+		for (int i = fname.indexOf('/'); i > 0; i = fname.indexOf('/', i + 1))
+			dirnames.insert(fname.left(i));
+		if (!fname.endsWith('/'))
+			names.append(fname);
+	}
+
+	QStringList files;
+	QList<int> pages;
+	foreach (const QString fname, names)
+	{
+		//
+		// some archivers list directories as regular entries; they are created
+		// before their contents are extracted, so they can't be used to track progress
+		if (dirnames.contains(fname))
+			continue;
+		if (knownImageExtension(fname))
+			pages.append(files.size());
+		else if (knownArchiveExtension(fname))
+		{
+			_DEBUG << "nested archive" << fname << "found, progressive mode disabled";
+			return false;
+		}
+		files.append(fname);
+	}
+	if (pages.isEmpty())
+		return false;
+	std::sort(pages.begin(), pages.end(), EntryPathComparator(files));
+
+	//
+	// register files and dirs the same way visit() would after extraction
+	QDir dir(destdir);
+	QStringList sorteddirs(dirnames.toList());
+	std::sort(sorteddirs.begin(), sorteddirs.end());
+	foreach (const QString d, sorteddirs)
+		archdirs.prepend(dir.absoluteFilePath(d)); //subdirectories go before their parents
+	foreach (const QString f, files)
+		archfiles.append(dir.absoluteFilePath(f));
+	pagepositions.clear();
+	foreach (int i, pages)
+	{
+		ImgDirSink::fileHandler(QFileInfo(dir.absoluteFilePath(files.at(i))));
+		pagepositions.append(i);
+	}
+	for (int i=0; i<files.size(); i++)
+	{
+		if (!knownImageExtension(files.at(i)))
+			ImgDirSink::fileHandler(QFileInfo(dir.absoluteFilePath(files.at(i))));
+	}
+	extractorder = files;
+	extracted = 0;
+	_DEBUG << pages.size() << "pages published before extraction";
+	return true;
+}
+
+void ImgArchiveSink::updateAvailable(bool finished)
+{
+	if (finished)
+	{
+		extracted = extractorder.size();
+	}
+	else
+	{
+		//
+		// extractors write entries one by one in archive order; an entry is complete
+		// as soon as the next one appears on disk
+		QDir dir(tmppath);
+		while (extracted + 1 < extractorder.size() && dir.exists(extractorder.at(extracted + 1)))
+			++extracted;
+	}
+
+	int n = available;
+	while (n < pagepositions.size() && pagepositions.at(n) < extracted)
+		++n;
+	if (n != available)
+	{
+		readermtx.lock();
+		available = n;
+		readermtx.unlock();
+		_DEBUG << "pages available:" << n;
+		emit pagesAvailable(n);
+	}
+}
+
 bool ImgArchiveSink::fileHandler(const QFileInfo &finfo)
 {
 	const QString fname = finfo.fileName();
@@ -92,8 +317,13 @@ bool ImgArchiveSink::fileHandler(const QFileInfo &finfo)
 
 void ImgArchiveSink::init()
 {
+	extracted = available = 0;
+	progressive = false;
 	pinf = new QProcess(this);
 	pext = new QProcess(this);
+	exttimer = new QTimer(this);
+	exttimer->setInterval(250);
+	connect(exttimer, SIGNAL(timeout()), this, SLOT(checkExtracted()));
 	connect(pinf, SIGNAL(readyReadStandardOutput()), this, SLOT(infoStdoutReady()));
 	connect(pinf, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(infoExited(int, QProcess::ExitStatus)));
 	connect(pext, SIGNAL(readyReadStandardOutput()), this, SLOT(extractStdoutReady()));
@@ -104,35 +334,36 @@ void ImgArchiveSink::doCleanup()
 {
 	if (!tmppath.isEmpty())
 	{
-		QDir dir(tmppath);
 		//
-		// remove temporary files and dirs
-		foreach (const QString f, archfiles)
-			dir.remove(f);
-		foreach (const QString f, archdirs)
-		{
-			dir.rmdir(f);
-		}
-		dir.rmdir(tmppath);
+		// remove temporary files and dirs in background; may take long on slow disks
+		SinkReaper::get()->removeTree(tmppath, archfiles.paths(), archdirs);
+		tmppath = QString::null;
 	}
+	archfiles.clear();
+	archdirs.clear();
 }
 
 int ImgArchiveSink::waitForFinished(QProcess *p)
 {
         //
-        // an ugly busy-loop with 1s sleep.
-        // waitForFinished(-1) hangs when used with processEvents().
+        // poll, so that cancelled open doesn't wait for the archiver
         for (;;)
         {
-            if (p->waitForFinished(1000) == true)
+            if (p->waitForFinished(100) == true)
                 break;
             if (p->state() == QProcess::NotRunning)
                 break;
+            if (openCancelled())
+            {
+                p->kill();
+                p->waitForFinished();
+                return false;
+            }
         }
         return p->exitStatus() == QProcess::NormalExit && p->exitCode() == 0;
 }
 
-int ImgArchiveSink::extract(const QString &filename, const QString &destdir, QStringList extargs, QStringList infargs)
+int ImgArchiveSink::extract(const QString &filename, const QString &destdir, QStringList extargs, QStringList infargs, const QRegExp &listpattern)
 {
     if (extargs.size() == 0 )
 		return SINKERR_UNKNOWNFILE;
@@ -148,14 +379,32 @@ int ImgArchiveSink::extract(const QString &filename, const QString &destdir, QSt
     
     //
     // extract archive file list first
+    listing.clear();
     pinf->start(infprg, infargs);
     
     if (!waitForFinished(pinf))
-        return SINKERR_ARCHEXIT;
+        return openCancelled() ? SINKERR_CANCELLED : SINKERR_ARCHEXIT;
     
     extcnt = 0;
+    if (!listpattern.isEmpty() && publishEntries(destdir, listpattern))
+    {
+        //
+        // pages are known from the listing already; extract in background
+        // and announce pages with pagesAvailable() as they are written
+        readermtx.lock();
+        available = 0;
+        progressive = true;
+        readermtx.unlock();
+        pext->start(extprg, extargs);
+        if (!pext->waitForStarted())
+            return SINKERR_ARCHEXIT;
+        exttimer->start();
+        return 0;
+    }
     pext->start(extprg, extargs);
-    return waitForFinished(pext) ? 0 : SINKERR_ARCHEXIT;
+    if (!waitForFinished(pext))
+        return openCancelled() ? SINKERR_CANCELLED : SINKERR_ARCHEXIT;
+    return 0;
 }
 
 int ImgArchiveSink::open(const QString &path) //TODO: cleanup if already opened?
@@ -173,17 +422,39 @@ int ImgArchiveSink::open(const QString &path) //TODO: cleanup if already opened?
 	{
 		if (info.isReadable())
 		{
+			//
+			// file is read once to find out its type; reader and extractor choice use the same head
+			const QByteArray head(FileTypeDetector::readHead(path));
+
+			//
+			// try in-process reader first; pages are decompressed on demand then
+			if (openReader(path, head))
+			{
+				//
+				// external extractors read the archive sequentially anyway, so bulk
+				// read applies to in-process readers only
+				if (bulkRead())
+					bulkReadEntries();
+				emit progress(1, 1);
+				return (numOfImages() > 0) ? 0 : SINKERR_EMPTY;
+			}
                         tmppath = makeTempDir(ComicBookSettings::instance().tmpDir());
 			archdirs.prepend(tmppath);
                         QStringList extractargs, listargs;
-                        ArchiversConfiguration::instance().getExtractArguments(path, extractargs, listargs);
-			int status = extract(path, tmppath, extractargs, listargs);
+                        ArchiversConfiguration::instance().getExtractArguments(path, head, extractargs, listargs);
+			int status = extract(path, tmppath, extractargs, listargs, ArchiversConfiguration::instance().getListPattern(path, head));
 			if (status != 0)
 			{
 				close();
 				return status;
 			}
-			visit(tmppath);
+			if (!progressive)
+				visit(tmppath);
+			if (openCancelled())
+			{
+				close();
+				return SINKERR_CANCELLED;
+			}
 			emit progress(1, 1);
 			return 0;
 		}
@@ -197,9 +468,345 @@ int ImgArchiveSink::open(const QString &path) //TODO: cleanup if already opened?
 
 void ImgArchiveSink::close()
 {
+	exttimer->stop();
+	if (pext->state() != QProcess::NotRunning)
+	{
+		//
+		// progressive open in progress; stop extractor before removing its files
+		readermtx.lock();
+		progressive = false;
+		readermtx.unlock();
+		pext->kill();
+		pext->waitForFinished();
+	}
+	extractorder.clear();
+	pagepositions.clear();
 	ImgDirSink::close();
 	doCleanup();
 	archivename = QString::null;
+
+	QMutexLocker lock(&readermtx);
+	if (!storekey.isEmpty())
+	{
+		foreach (int entry, pageEntries)
+			BulkStore::instance().remove(storekey + QString::number(entry));
+		storekey = QString::null;
+	}
+	bookindex.save();
+	bookindex = BookIndex();
+	reader.clear();
+	pageEntries.clear();
+	textEntries.clear();
+	readerdesc.clear();
+}
+
+void ImgArchiveSink::watchChanges()
+{
+}
+
+QImage ImgArchiveSink::image(unsigned int num, int &result, const CancelToken *cancel)
+{
+	readermtx.lock();
+	QSharedPointer<ArchiveReader> r(reader);
+	const int entry = (num < pageEntries.count()) ? pageEntries.at(num) : -1;
+	readermtx.unlock();
+
+	if (!r)
+		return ImgDirSink::image(num, result, cancel);
+
+	result = SINKERR_LOADERROR;
+	QImage im;
+	if (isCancelled(cancel))
+		result = SINKERR_CANCELLED;
+	else if (entry >= 0)
+	{
+		QByteArray data;
+		if (!bulkRead() || !BulkStore::instance().get(storekey + QString::number(entry), data))
+			data = r->read(entry);
+		//
+		// entry can't be decompressed partially; give up before decoding at least
+		if (isCancelled(cancel))
+			result = SINKERR_CANCELLED;
+		else
+			im = decodeEntry(num, r->entries().at(entry).name, data, result, cancel);
+	}
+	return im;
+}
+
+QList<QImage> ImgArchiveSink::images(const QList<int> &nums, QList<int> &results)
+{
+	readermtx.lock();
+	QSharedPointer<ArchiveReader> r(reader);
+	QList<int> entries;
+	foreach (int num, nums)
+		entries.append((num >= 0 && num < pageEntries.count()) ? pageEntries.at(num) : -1);
+	readermtx.unlock();
+
+	if (!r)
+		return ImgDirSink::images(nums, results);
+
+	QList<QByteArray> data(entryData(r, entries));
+	QList<QImage> imgs;
+	results.clear();
+	for (int i=0; i<nums.size(); i++)
+	{
+		int result = SINKERR_LOADERROR;
+		QImage im;
+		if (entries.at(i) >= 0)
+			im = decodeEntry(nums.at(i), r->entries().at(entries.at(i)).name, data[i], result);
+		imgs.append(im);
+		results.append(result);
+	}
+	return imgs;
+}
+
+QList<QSize> ImgArchiveSink::pageSizes(const QList<int> &nums)
+{
+	QList<QSize> sizes;
+	QList<int> entries;
+	QList<int> positions;
+	readermtx.lock();
+	QSharedPointer<ArchiveReader> r(reader);
+	for (int i=0; i<nums.size(); i++)
+	{
+		sizes.append(bookindex.pageSize(nums.at(i)));
+		if (!sizes.at(i).isValid() && nums.at(i) >= 0 && nums.at(i) < pageEntries.count())
+		{
+			entries.append(pageEntries.at(nums.at(i)));
+			positions.append(i);
+		}
+	}
+	readermtx.unlock();
+
+	if (!r)
+		return ImgDirSink::pageSizes(nums);
+	if (entries.isEmpty())
+		return sizes;
+
+	//
+	// entries have to be decompressed, but only headers are parsed;
+	// sizes go to the book index, so it's done once per book
+	QList<QByteArray> data(entryData(r, entries));
+	for (int i=0; i<positions.size(); i++)
+	{
+		QBuffer buf(&data[i]);
+		buf.open(QIODevice::ReadOnly);
+		QImageReader imReader(&buf, QFileInfo(r->entries().at(entries.at(i)).name).suffix().toLower().toLatin1());
+		imReader.setDecideFormatFromContent(true);
+		const QSize s(imReader.size());
+		if (s.isValid())
+		{
+			sizes[positions.at(i)] = s;
+			readermtx.lock();
+			bookindex.setPageSize(nums.at(positions.at(i)), s);
+			readermtx.unlock();
+		}
+	}
+	return sizes;
+}
+
+QList<QByteArray> ImgArchiveSink::entryData(const QSharedPointer<ArchiveReader> &r, const QList<int> &entries)
+{
+	//
+	// entries not in bulk store are decompressed together
+	QList<QByteArray> data;
+	QList<int> toread;
+	QList<int> positions;
+	for (int i=0; i<entries.size(); i++)
+	{
+		data.append(QByteArray());
+		if (entries.at(i) >= 0 && (!bulkRead() || !BulkStore::instance().get(storekey + QString::number(entries.at(i)), data[i])))
+		{
+			toread.append(entries.at(i));
+			positions.append(i);
+		}
+	}
+	if (toread.size())
+	{
+		const QList<QByteArray> rd(r->readEntries(toread));
+		for (int i=0; i<positions.size() && i<rd.size(); i++)
+			data[positions.at(i)] = rd.at(i);
+	}
+	return data;
+}
+
+QImage ImgArchiveSink::decodeEntry(unsigned int num, const QString &name, QByteArray &data, int &result, const CancelToken *cancel)
+{
+	QImage im;
+	QBuffer buf(&data);
+	buf.open(QIODevice::ReadOnly);
+	QScopedPointer<CancellableDevice> cdev;
+	if (cancel)
+		cdev.reset(new CancellableDevice(&buf, cancel));
+	QImageReader imReader(cdev ? static_cast<QIODevice *>(cdev.data()) : &buf, QFileInfo(name).suffix().toLower().toLatin1());
+	imReader.setDecideFormatFromContent(true);
+	const QSize full(applyDecodeSize(imReader));
+	result = SINKERR_LOADERROR;
+	if (!imReader.read(&im))
+	{
+		if (isCancelled(cancel))
+			result = SINKERR_CANCELLED;
+	}
+	else if (isCancelled(cancel))
+	{
+		//
+		// some decoders return partial image instead of failing
+		result = SINKERR_CANCELLED;
+		im = QImage();
+	}
+	else
+	{
+		result = 0;
+		readermtx.lock();
+		bookindex.setPageSize(num, full.isValid() ? full : im.size()); //index keeps full resolution
+		readermtx.unlock();
+	}
+	return im;
+}
+
+void ImgArchiveSink::bulkReadEntries()
+{
+	readermtx.lock();
+	QSharedPointer<ArchiveReader> r(reader);
+	QList<int> entries(pageEntries);
+	readermtx.unlock();
+	if (!r)
+		return;
+
+	storekey = archivepath + ":" + QString::number(QFileInfo(archivepath).lastModified().toMSecsSinceEpoch()) + ":";
+	std::sort(entries.begin(), entries.end()); //order of entries in the archive
+
+	BulkStore &store(BulkStore::instance());
+	QByteArray data;
+	QList<int> toread;
+	qint64 total = 0;
+	for (int i=0; i<entries.size(); i++)
+	{
+		//
+		// pages of other books are evicted, but not leading pages of this very book;
+		// streamed formats may not know the size, compressed size is the best estimate then
+		const ArchiveEntry &e(r->entries().at(entries.at(i)));
+		if (e.size >= 0)
+			total += e.size;
+		else if (e.compressedSize >= 0)
+			total += e.compressedSize;
+		if (total > store.maxSize())
+			break;
+		if (!store.get(storekey + QString::number(entries.at(i)), data))
+			toread.append(entries.at(i));
+	}
+	if (toread.isEmpty() || openCancelled())
+		return;
+
+	//
+	// single pass over the archive; reading entries one by one would make stream
+	// formats (compressed tar, non-solid 7z and rar) decompress from the start for each
+	QList<QByteArray> rd(r->readEntries(toread));
+	for (int i=0; i<rd.size() && i<toread.size() && !openCancelled(); i++)
+	{
+		store.insert(storekey + QString::number(toread.at(i)), rd.at(i));
+		rd[i] = QByteArray();
+		emit progress(i + 1, toread.size());
+	}
+}
+
+int ImgArchiveSink::availableImages() const
+{
+	QMutexLocker lock(&readermtx);
+	if (progressive)
+		return available;
+	lock.unlock();
+	return numOfImages();
+}
+
+int ImgArchiveSink::numOfImages() const
+{
+	QMutexLocker lock(&readermtx);
+	if (reader)
+		return pageEntries.count();
+	lock.unlock();
+	return ImgDirSink::numOfImages();
+}
+
+QString ImgArchiveSink::getFullFileName(int page) const
+{
+	QMutexLocker lock(&readermtx);
+	if (reader)
+	{
+		//
+		// there is no file on disk; return path of the image inside the archive
+		if (page >= 0 && page < pageEntries.count())
+			return archivepath + "/" + reader->entries().at(pageEntries.at(page)).name;
+		return QString::null;
+	}
+	lock.unlock();
+	return ImgDirSink::getFullFileName(page);
+}
+
+QByteArray ImgArchiveSink::getPageData(int page)
+{
+	readermtx.lock();
+	QSharedPointer<ArchiveReader> r(reader);
+	const int entry = (page >= 0 && page < pageEntries.count()) ? pageEntries.at(page) : -1;
+	readermtx.unlock();
+
+	QByteArray data;
+	if (r && entry >= 0 && (!bulkRead() || !BulkStore::instance().get(storekey + QString::number(entry), data)))
+		data = r->read(entry);
+	return data;
+}
+
+QStringList ImgArchiveSink::getDescription() const
+{
+	QMutexLocker lock(&readermtx);
+	QSharedPointer<ArchiveReader> r(reader);
+	const QList<int> texts(textEntries);
+	const bool indexed = bookindex.hasDescription();
+	const bool read = readerdesc.count() > 0;
+	lock.unlock();
+
+	if (!r)
+		return ImgDirSink::getDescription();
+
+	if (!read && !indexed) //read files only once
+	{
+		//
+		// files are read without the lock; readerdesc is written under it, as in close()
+		QStringList desc;
+		foreach (int i, texts)
+		{
+			const ArchiveEntry &e(r->entries().at(i));
+			if (e.size >= MAX_TEXTFILE_SIZE)
+				continue;
+			QByteArray data(r->read(i));
+			if (data.size() < MAX_TEXTFILE_SIZE)
+			{
+				QString cont;
+				QTextStream str(&data, QIODevice::ReadOnly);
+				while (!str.atEnd())
+					cont += str.readLine() + "\n";
+				desc.append(e.name.section('/', -1)); //append file name
+				desc.append(cont); //and contents
+			}
+		}
+		lock.relock();
+		if (reader == r && readerdesc.count() == 0) //not closed or filled by another thread meanwhile
+		{
+			readerdesc = desc;
+			bookindex.setDescription(readerdesc);
+		}
+		return desc;
+	}
+	lock.relock();
+	return readerdesc;
+}
+
+bool ImgArchiveSink::timestampDiffers(int page) const
+{
+	readermtx.lock();
+	const bool inprocess = !reader.isNull();
+	readermtx.unlock();
+	return inprocess ? false : ImgDirSink::timestampDiffers(page);
 }
 
 void ImgArchiveSink::infoExited(int code, QProcess::ExitStatus exitStatus)
@@ -211,17 +818,35 @@ void ImgArchiveSink::extractExited(int code, QProcess::ExitStatus exitStatus)
 	//
 	// fix permissions of files; this is needed for ace archives as unace
 	// is buggy and sets empty permissions.
-	foreach (const QString f, archfiles)
+	for (int i=0; i<archfiles.size(); i++)
 	{
+		const QString f(archfiles.path(i));
 		QFileInfo finfo(f);
 		if (!finfo.isReadable())
 			chmod(f.toLocal8Bit(), S_IRUSR|S_IWUSR);
 	}
+
+	if (progressive)
+	{
+		exttimer->stop();
+		_DEBUG << "background extraction finished with code" << code;
+		updateAvailable(true);
+		readermtx.lock();
+		progressive = false;
+		readermtx.unlock();
+	}
+}
+
+void ImgArchiveSink::checkExtracted()
+{
+	if (progressive)
+		updateAvailable(false);
 }
 
 void ImgArchiveSink::infoStdoutReady()
 {
 	QByteArray b = pinf->readAllStandardOutput();
+	listing.append(b);
 	for (int i=0; i<b.size(); i++)
 		if (b[i] == '\n')
 			++filesnum;
@@ -230,11 +855,15 @@ void ImgArchiveSink::infoStdoutReady()
 void ImgArchiveSink::extractStdoutReady()
 {
 	QByteArray b = pext->readAllStandardOutput();
+	if (progressive)
+	{
+		checkExtracted();
+		return;
+	}
 	for (int i=0; i<b.size(); i++)
 		if (b[i] == '\n' && extcnt < filesnum)
 			++extcnt;
 	emit progress(extcnt, filesnum);
-	qApp->processEvents(QEventLoop::ExcludeSocketNotifiers | QEventLoop::ExcludeUserInputEvents);
 }
 
 QString ImgArchiveSink::makeTempDir(const QString &parent)
@@ -272,25 +901,37 @@ bool ImgArchiveSink::supportsNext() const
 	return true;
 }
 
+const QStringList& ImgArchiveSink::siblingArchives() const
+{
+	//
+	// listing is repeated only if directory contents changed
+	const QFileInfo dinfo(QFileInfo(getFullName()).absolutePath());
+	if (dinfo.lastModified() != siblingstime)
+	{
+		siblingstime = dinfo.lastModified();
+		QDir dir(dinfo.absoluteFilePath());
+		siblings = dir.entryList(ArchiversConfiguration::instance().supportedOpenExtensions(), QDir::Files|QDir::Readable, QDir::Name);
+	}
+	return siblings;
+}
+
 QString ImgArchiveSink::getNext() const
 {
 	QFileInfo finfo(getFullName());
-	QDir dir(finfo.absolutePath()); //get the full path of current cb
-	QStringList files = dir.entryList(ArchiversConfiguration::instance().supportedOpenExtensions(), QDir::Files|QDir::Readable, QDir::Name);
+	const QStringList &files(siblingArchives());
 	int i = files.indexOf(finfo.fileName()); //find current cb
 	if ((i >= 0) && (i < files.size()-1))
-		return dir.absoluteFilePath(files.at(i+1));  //get next file name
+		return finfo.absoluteDir().absoluteFilePath(files.at(i+1));  //get next file name
 	return QString::null;
 }
 
 QString ImgArchiveSink::getPrevious() const
 {
 	QFileInfo finfo(getFullName());
-	QDir dir(finfo.absolutePath()); //get the full path of current cb
-	QStringList files = dir.entryList(ArchiversConfiguration::instance().supportedOpenExtensions(), QDir::Files|QDir::Readable, QDir::Name);
+	const QStringList &files(siblingArchives());
 	int i = files.indexOf(finfo.fileName()); //find current cb
 	if (i > 0)
-		return dir.absoluteFilePath(files.at(i-1));
+		return finfo.absoluteDir().absoluteFilePath(files.at(i-1));
 	return QString::null;
 }
 
@@ -20,12 +20,20 @@
 #include <QStringList>
 #include <QList>
 #include <QProcess>
+#include <QRegExp>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QDateTime>
 #include "ImgDirSink.h"
+#include "BookIndex.h"
 
 class QImage;
 
 namespace QComicBook
 {
+	class ArchiveReader;
+
 	//! Comic book archive sink.
 	/*! Allows opening different kind of archives containing image files. */
 	class ImgArchiveSink: public ImgDirSink
@@ -35,16 +43,45 @@ namespace QComicBook
 		protected:
 			QProcess *pext; ///< extracting process
 			QProcess *pinf; ///< file list extracing process
+			QTimer *exttimer; ///< polls extracted files in progressive mode
 			QString archivename; ///< archive file name, without path
 			QString archivepath; ///< full path, including archive name
 			QString tmppath; ///< path to extracted archive
-			QStringList archfiles; ///< list of archive files
+			PageTable archfiles; ///< list of archive files
 			QStringList archdirs; ///< list of archive dirs
 			int filesnum; ///< number of files gathered from parsing archiver output, used for progress bar
 			int extcnt; ///< extracted files counter for progress bar
+			QByteArray listing; ///< output of list command
+			QStringList extractorder; ///< archive entries in the order they are extracted; used in progressive mode
+			QList<int> pagepositions; ///< position in extractorder for every page, in reading order
+			int extracted; ///< number of leading entries of extractorder that are completely extracted
+			int available; ///< number of leading pages that can be read; guarded by readermtx
+			bool progressive; ///< true if archive is extracted in background after its pages were published
+			QSharedPointer<ArchiveReader> reader; ///< in-process reader; NULL if archive was extracted to tmppath
+			QList<int> pageEntries; ///< reader entries of images, in reading order
+			QList<int> textEntries; ///< reader entries of .nfo and file_id.diz files
+			mutable QStringList readerdesc; ///< contents of text entries
+			mutable BookIndex bookindex; ///< persistent index of the archive, used with reader
+			mutable QMutex readermtx; ///< mutex for reader, entries lists and bookindex
+			QString storekey; ///< prefix of BulkStore keys of reader entries; identifies archive and its version
+			mutable QStringList siblings; ///< archives in the directory of this one, sorted by name
+			mutable QDateTime siblingstime; ///< modification time of the directory when siblings were listed
 
-			static int waitForFinished(QProcess *p);
-			int extract(const QString &filename, const QString &destdir, QStringList extargs, QStringList infargs);
+			int waitForFinished(QProcess *p);
+			static bool knownArchiveExtension(const QString &path);
+			bool openReader(const QString &path, const QByteArray &head);
+			//! Reads all pages with in-process reader into BulkStore, in archive order.
+			void bulkReadEntries();
+			//! Returns contents of entries, taken from BulkStore or decompressed with a single readEntries() call.
+			QList<QByteArray> entryData(const QSharedPointer<ArchiveReader> &r, const QList<int> &entries);
+			//! Decodes page image from entry data and records its size in bookindex.
+			QImage decodeEntry(unsigned int num, const QString &name, QByteArray &data, int &result, const CancelToken *cancel = NULL);
+			const QStringList& siblingArchives() const;
+			//! Splits reader entries into pages and text files; returns false if any entry is an archive.
+			static bool classifyEntries(const QList<ArchiveEntry> &entries, QList<int> &pages, QList<int> &texts, QStringList &names);
+			int extract(const QString &filename, const QString &destdir, QStringList extargs, QStringList infargs, const QRegExp &listpattern = QRegExp());
+			bool publishEntries(const QString &destdir, const QRegExp &listpattern);
+			void updateAvailable(bool finished);
 			void init();
 			virtual void doCleanup();
 			
@@ -55,6 +92,7 @@ namespace QComicBook
 			void extractStdoutReady();
 			void infoStdoutReady();
 			void infoExited(int code, QProcess::ExitStatus exitStatus);
+			void checkExtracted();
 
 		public:
 			ImgArchiveSink();
@@ -64,6 +102,21 @@ namespace QComicBook
 
 			virtual int open(const QString &path);
 			virtual void close();
+			//! Does nothing; extracted files belong to the sink and don't change.
+			virtual void watchChanges();
+
+			virtual QImage image(unsigned int num, int &result, const CancelToken *cancel = NULL);
+			//! Decompresses pages not in bulk store with a single ArchiveReader::readEntries() call.
+			virtual QList<QImage> images(const QList<int> &nums, QList<int> &results);
+			//! Takes sizes from the book index; sizes of other pages are probed and added to the index.
+			virtual QList<QSize> pageSizes(const QList<int> &nums);
+			virtual int numOfImages() const;
+			virtual int availableImages() const;
+			virtual QString getFullFileName(int page) const;
+			//! Returns contents of the page entry if archive is read in-process.
+			virtual QByteArray getPageData(int page);
+			virtual QStringList getDescription() const;
+			virtual bool timestampDiffers(int page) const;
 
 			virtual bool supportsNext() const;
 			virtual QString getNext() const;
@@ -13,6 +13,12 @@
 #include "ImgDirSink.h"
 #include "ComicBookSettings.h"
 #include "ImageFormatsInfo.h"
+#include "BulkStore.h"
+#include "CancelToken.h"
+#include "CancellableDevice.h"
+#include "../NaturalComparator.h"
+#include "../ComicBookDebug.h"
+#include "Utility.h"
 #include <QImage>
 #include <QStringList>
 #include <QDir>
@@ -20,30 +26,61 @@
 #include <QFileInfo>
 #include <QTextStream>
 #include <QImageReader>
+#include <QBuffer>
+#include <QMutexLocker>
+#include <QFileSystemWatcher>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QScopedPointer>
 
 using namespace QComicBook;
 
 //
 // maximum size of description file (won't load files larger than that)
 const int ImgDirSink::MAX_TEXTFILE_SIZE = 65535;
+
+//
+// bounds of the number of pages read ahead of the page being loaded
+const int ImgDirSink::MIN_READAHEAD = 2;
+const int ImgDirSink::MAX_READAHEAD = 16;
+
+//
+// bytes read to measure latency of the medium before the page is decoded
+const int ImgDirSink::LATENCY_PROBE_SIZE = 4096;
+
+//
+// lists directory of the sink after open() returned
+class ImgDirSink::Scanner: public QThread
+{
+	public:
+		Scanner(ImgDirSink *sink): QThread(), sink(sink) {}
+
+	protected:
+		virtual void run()
+		{
+			sink->scan();
+		}
+
+	private:
+		ImgDirSink *sink;
+};
                         
-ImgDirSink::ImgDirSink(bool dirs, int cacheSize): ImgSink(cacheSize), dirpath(QString::null), DirReader(QDir::DirsLast|QDir::Name|QDir::IgnoreCase, 6)
+ImgDirSink::ImgDirSink(bool dirs, int cacheSize): ImgSink(cacheSize), dirpath(QString::null), DirReader(QDir::DirsLast|QDir::Name|QDir::IgnoreCase, 6), watcher(NULL), rescan(false), readahead(MIN_READAHEAD), advised(-1), loadtime(0), scanner(NULL), scanning(false), published(false), announced(0), watchpending(false)
 {
 }
 
-ImgDirSink::ImgDirSink(const QString &path, bool dirs, int cacheSize): ImgSink(cacheSize), dirpath(QString::null), DirReader(QDir::DirsLast|QDir::Name|QDir::IgnoreCase, 6)
+ImgDirSink::ImgDirSink(const QString &path, bool dirs, int cacheSize): ImgSink(cacheSize), dirpath(QString::null), DirReader(QDir::DirsLast|QDir::Name|QDir::IgnoreCase, 6), watcher(NULL), rescan(false), readahead(MIN_READAHEAD), advised(-1), loadtime(0), scanner(NULL), scanning(false), published(false), announced(0), watchpending(false)
 {
 	open(path);
 }
 
-ImgDirSink::ImgDirSink(const ImgDirSink &sink, int cacheSize): ImgSink(cacheSize), DirReader(QDir::DirsLast|QDir::Name|QDir::IgnoreCase, 6)
+ImgDirSink::ImgDirSink(const ImgDirSink &sink, int cacheSize): ImgSink(cacheSize), DirReader(QDir::DirsLast|QDir::Name|QDir::IgnoreCase, 6), watcher(NULL), rescan(false), readahead(MIN_READAHEAD), advised(-1), loadtime(0), scanner(NULL), scanning(false), published(false), announced(0), watchpending(false)
 {
 	dirpath = sink.dirpath;
 	imgfiles = sink.imgfiles;
 	txtfiles = sink.txtfiles;
 	otherfiles = sink.otherfiles;
 	dirs = sink.dirs;
-	timestamps = sink.timestamps;
 }
 
 ImgDirSink::~ImgDirSink()
@@ -76,19 +113,96 @@ bool ImgDirSink::fileHandler(const QFileInfo &finfo)
 	const QString fname = finfo.fileName();
 	if (knownImageExtension(fname))
 	{
+		//
+		// no stat here; timestamp is recorded when the page is loaded
+		listmtx.lock();
 		imgfiles.append(finfo.absoluteFilePath());
-		timestamps.insert(finfo.absoluteFilePath(), FileStatus(finfo.lastModified()));
+		listmtx.unlock();
 		return true;
 	}
 	if (fname.endsWith(".nfo", Qt::CaseInsensitive) || fname == "file_id.diz")
 	{
+		listmtx.lock();
 		txtfiles.append(finfo.absoluteFilePath());
+		listmtx.unlock();
 		return true;
 	}
+	listmtx.lock();
 	otherfiles.append(finfo.absoluteFilePath());
+	listmtx.unlock();
 	return false;
 }
 
+bool ImgDirSink::visitCancelled() const
+{
+	return openCancelled() || scanstop.load();
+}
+
+void ImgDirSink::batchDone()
+{
+	listmtx.lock();
+	if (!scanning || imgfiles.size() == announced)
+	{
+		listmtx.unlock();
+		return;
+	}
+	announced = imgfiles.size();
+	const int total = announced;
+	const bool publish = published;
+	listmtx.unlock();
+	scancond.wakeAll();
+	if (publish)
+	{
+		_DEBUG << "pages found:" << total;
+		emit pagesAdded(total);
+		emit pagesAvailable(total);
+	}
+}
+
+void ImgDirSink::scan()
+{
+	visit(dirpath);
+	listmtx.lock();
+	scanning = false;
+	listmtx.unlock();
+	scancond.wakeAll();
+	QMetaObject::invokeMethod(this, "scanFinished", Qt::QueuedConnection);
+}
+
+void ImgDirSink::scanFinished()
+{
+	listmtx.lock();
+	const bool done = !scanning;
+	listmtx.unlock();
+	//
+	// call may come from the scan of a previous open; only a finished scanner is deleted
+	if (scanner && done)
+	{
+		scanner->wait();
+		delete scanner;
+		scanner = NULL;
+	}
+	if (!scanner && watchpending)
+	{
+		watchpending = false;
+		watchChanges();
+	}
+}
+
+void ImgDirSink::stopScan()
+{
+	if (!scanner)
+		return;
+	scanstop.store(1);
+	scanner->wait();
+	delete scanner;
+	scanner = NULL;
+	scanstop.store(0);
+	listmtx.lock();
+	scanning = false;
+	listmtx.unlock();
+}
+
 int ImgDirSink::open(const QString &path)
 {
         int status;
@@ -103,8 +217,35 @@ int ImgDirSink::open(const QString &path)
                         if (info.isReadable() && info.isExecutable())
                         {
                                 dirpath = path;
-				visit(path);
-                                status = (numOfImages() > 0) ? 0 : SINKERR_EMPTY;
+				//
+				// directory is listed in background; first pages can be shown
+				// while the rest of a large tree is being listed
+				listmtx.lock();
+				scanning = true;
+				published = false;
+				announced = 0;
+				listmtx.unlock();
+				scanner = new Scanner(this);
+				scanner->start();
+
+				listmtx.lock();
+				while (scanning && (announced == 0 || bulkRead()))
+					scancond.wait(&listmtx);
+				published = true;
+				const bool done = !scanning;
+				listmtx.unlock();
+				if (done)
+				{
+					scanner->wait();
+					delete scanner;
+					scanner = NULL;
+				}
+				if (bulkRead())
+					bulkReadPages();
+				if (openCancelled())
+					status = SINKERR_CANCELLED;
+				else
+					status = (numOfImages() > 0) ? 0 : SINKERR_EMPTY;
                         }
                         else
                                 status = SINKERR_ACCESS;
@@ -119,25 +260,160 @@ int ImgDirSink::open(const QString &path)
 
 void ImgDirSink::close()
 {
+        stopScan();
+        watchpending = false;
+        pageindex.clear();
         listmtx.lock();
+        foreach (const QString &key, storekeys)
+        {
+                if (!key.isEmpty())
+                        BulkStore::instance().remove(key);
+        }
+        storekeys.clear();
+        delete watcher;
+        watcher = NULL;
         dirpath = QString::null;
         imgfiles.clear();
         txtfiles.clear();
         otherfiles.clear();
         dirs.clear();
+        dirty.clear();
+        dims.clear();
+        rescan = false;
+        advised = -1;
         listmtx.unlock();
 }
 
+void ImgDirSink::watchChanges()
+{
+	if (watcher || dirpath.isEmpty())
+		return;
+	if (scanner)
+	{
+		//
+		// page list isn't complete yet; see scanFinished()
+		watchpending = true;
+		return;
+	}
+
+	listmtx.lock();
+	const QStringList files(imgfiles.paths());
+	const QStringList dirs(imgfiles.directories());
+	listmtx.unlock();
+
+	for (int i=0; i<files.size(); i++)
+		pageindex.insert(files.at(i), i);
+
+	QFileSystemWatcher *w = new QFileSystemWatcher(this);
+	connect(w, SIGNAL(fileChanged(const QString &)), this, SLOT(fileChanged(const QString &)));
+	connect(w, SIGNAL(directoryChanged(const QString &)), this, SLOT(directoryChanged(const QString &)));
+	w->addPaths(dirs);
+	if (!files.isEmpty())
+		w->addPaths(files);
+
+	listmtx.lock();
+	watcher = w; //from now on timestampDiffers() and hasModifiedFiles() rely on dirty set
+	listmtx.unlock();
+}
+
+void ImgDirSink::fileChanged(const QString &path)
+{
+	const QHash<QString, int>::const_iterator it = pageindex.constFind(path);
+	if (it == pageindex.constEnd())
+		return;
+	const int page = it.value();
+
+	//
+	// file replaced by rename is not watched anymore
+	if (QFile::exists(path) && !watcher->files().contains(path))
+		watcher->addPath(path);
+
+	listmtx.lock();
+	dirty.insert(page);
+	if (page < dims.size())
+		dims[page] = QSize();
+	listmtx.unlock();
+	dropStored(page);
+	_DEBUG << "page" << page << "changed";
+	invalidatePage(page);
+}
+
+void ImgDirSink::directoryChanged(const QString &path)
+{
+	const QDir dir(path);
+	const QString prefix(dir.absolutePath() + "/");
+	const QStringList files(dir.entryList(QDir::Files));
+	const QSet<QString> present(QSet<QString>::fromList(files));
+
+	QStringList added;
+	foreach (const QString &f, files)
+	{
+		if (knownImageExtension(f) && !pageindex.contains(prefix + f))
+			added.append(f);
+	}
+	naturalSort(added);
+
+	QList<int> removed;
+	listmtx.lock();
+	for (int i=0; i<imgfiles.size(); i++)
+	{
+		if (!dirty.contains(i) && imgfiles.directory(i) == prefix && !present.contains(imgfiles.fileName(i)))
+		{
+			dirty.insert(i);
+			if (i < dims.size())
+				dims[i] = QSize();
+			removed.append(i);
+		}
+	}
+
+	//
+	// new files are appended only if they come after the last page; anything else
+	// would renumber pages, so it is left for the next open
+	const NaturalComparator cmp;
+	QStringList appended;
+	foreach (const QString &f, added)
+	{
+		const int last = imgfiles.size() - 1;
+		if (last >= 0 && (imgfiles.directory(last) != prefix || !cmp(imgfiles.fileName(last), f)))
+		{
+			rescan = true;
+			continue;
+		}
+		pageindex.insert(prefix + f, imgfiles.size());
+		imgfiles.append(prefix + f);
+		appended.append(prefix + f);
+	}
+	const int total = imgfiles.size();
+	listmtx.unlock();
+
+	foreach (int page, removed)
+	{
+		dropStored(page);
+		invalidatePage(page);
+	}
+	if (!appended.isEmpty())
+	{
+		watcher->addPaths(appended);
+		_DEBUG << appended.size() << "pages added";
+		emit pagesAdded(total);
+		emit pagesAvailable(total);
+	}
+}
+
 QString ImgDirSink::getFullFileName(int page) const
 {
-	return page < numOfImages() ? imgfiles[page] : QString::null;
+	QMutexLocker locker(&listmtx);
+	return (page >= 0 && page < imgfiles.size()) ? imgfiles.path(page) : QString::null;
 }
 
 QStringList ImgDirSink::getDescription() const
 {
 	if (desc.count() == 0) //read files only once
 	{
-		for (QStringList::const_iterator it = txtfiles.begin(); it!=txtfiles.end(); it++)
+		listmtx.lock();
+		const QStringList files(txtfiles.paths());
+		listmtx.unlock();
+		for (QStringList::const_iterator it = files.begin(); it!=files.end(); it++)
 		{
 			QFileInfo finfo(*it);
 			QFile f(*it);
@@ -156,27 +432,119 @@ QStringList ImgDirSink::getDescription() const
         return desc;
 }
 
-QImage ImgDirSink::image(unsigned int num, int &result)
+void ImgDirSink::setPageSize(int num, const QSize &s)
+{
+	QMutexLocker locker(&listmtx);
+	if (num < 0 || num >= imgfiles.size())
+		return;
+	if (dims.size() < imgfiles.size())
+		dims.resize(imgfiles.size());
+	dims[num] = s;
+}
+
+QList<QSize> ImgDirSink::pageSizes(const QList<int> &nums)
+{
+	QList<QSize> sizes;
+	foreach (int num, nums)
+	{
+		listmtx.lock();
+		QSize s((num >= 0 && num < dims.size()) ? dims.at(num) : QSize());
+		const QString fname((num >= 0 && num < imgfiles.size()) ? imgfiles.path(num) : QString());
+		const QString key((num >= 0 && num < storekeys.size()) ? storekeys.at(num) : QString());
+		listmtx.unlock();
+
+		if (!s.isValid() && !fname.isEmpty())
+		{
+			//
+			// size() only parses the header; pages read in bulk don't touch the medium again
+			QByteArray data;
+			QBuffer buf;
+			QImageReader imReader;
+			if (!key.isEmpty() && BulkStore::instance().get(key, data))
+			{
+				buf.setData(data);
+				buf.open(QIODevice::ReadOnly);
+				imReader.setDevice(&buf);
+				imReader.setFormat(QFileInfo(fname).suffix().toLower().toLatin1());
+			}
+			else
+				imReader.setFileName(fname);
+			imReader.setDecideFormatFromContent(true);
+			s = imReader.size();
+			if (s.isValid())
+				setPageSize(num, s);
+		}
+		sizes.append(s);
+	}
+	return sizes;
+}
+
+QImage ImgDirSink::image(unsigned int num, int &result, const CancelToken *cancel)
 {
 	result = SINKERR_LOADERROR;
 
 	listmtx.lock();
-	const int imgcnt = imgfiles.count();
+	const int imgcnt = imgfiles.size();
 	QImage im;
 
 	if (num < imgcnt)
 	{
-		const QString fname = imgfiles[num];
+		const QString fname = imgfiles.path(num);
+		const QString key(num < storekeys.size() ? storekeys.at(num) : QString());
 		listmtx.unlock();
-        QImageReader imReader(fname);
+		QByteArray data;
+		QFile file(fname);
+		const bool stored = !key.isEmpty() && BulkStore::instance().get(key, data);
+		QBuffer buf(&data);
+		buf.open(QIODevice::ReadOnly);
+		QIODevice *dev = &buf;
+		if (!stored)
+		{
+			//
+			// only opening the file and its first read are timed, so that read-ahead window
+			// follows latency of the medium rather than size of the page; peek() keeps the
+			// data buffered for the decoder. Pages from BulkStore don't touch the medium at all
+			QElapsedTimer timer;
+			timer.start();
+			if (file.open(QIODevice::ReadOnly))
+			{
+				file.peek(LATENCY_PROBE_SIZE);
+				readAhead(num, timer.nsecsElapsed() / 1000);
+				dev = &file;
+			}
+		}
+		QScopedPointer<CancellableDevice> cdev;
+		//
+		// decoder reads its input chunk by chunk, so cancelled device stops it midway
+		if (cancel)
+		{
+			cdev.reset(new CancellableDevice(dev, cancel));
+			dev = cdev.data();
+		}
+        QImageReader imReader(dev, QFileInfo(fname).suffix().toLower().toLatin1());
         imReader.setDecideFormatFromContent(true);
         if (!imReader.canRead())
          result = 1;
         else
          result = 0;
+		const QSize full(applyDecodeSize(imReader));
 
         im = imReader.read();
-        
+		if (isCancelled(cancel))
+		{
+			result = SINKERR_CANCELLED;
+			im = QImage();
+		}
+
+		if (result == 0)
+		{
+			const QDateTime mtime(QFileInfo(fname).lastModified());
+			listmtx.lock();
+			if (num < imgfiles.size() && (dirty.remove(num) || !imgfiles.hasTimestamp(num)))
+				imgfiles.setTimestamp(num, mtime);
+			listmtx.unlock();
+			setPageSize(num, full.isValid() ? full : im.size());
+		}
 
 		// if (!im.load(fname))
 		// 	result = 1;
@@ -203,10 +571,88 @@ QImage ImgDirSink::image(unsigned int num, int &result)
 	return page;
 }
 
+void ImgDirSink::readAhead(unsigned int num, qint64 elapsed)
+{
+	QStringList files;
+
+	listmtx.lock();
+	loadtime = loadtime ? (3*loadtime + elapsed) / 4 : elapsed;
+	//
+	// one more page for every 25ms of read time; a cold read from a spinning
+	// disk or network mount takes tens of milliseconds, SSD a fraction of that
+	readahead = qBound<qint64>(MIN_READAHEAD, MIN_READAHEAD + loadtime / 25000, MAX_READAHEAD);
+
+	const int last = qMin<int>(num + readahead, imgfiles.size() - 1);
+	if (advised < static_cast<int>(num) || advised > last + readahead) //moved forward past the window or jumped back
+		advised = num;
+	for (int i=advised + 1; i<=last; i++)
+		files.append(imgfiles.path(i));
+	if (last > advised)
+		advised = last;
+	listmtx.unlock();
+
+	foreach (const QString &f, files)
+		Utility::willNeed(f);
+}
+
+void ImgDirSink::bulkReadPages()
+{
+	listmtx.lock();
+	const QStringList files(imgfiles.paths());
+	listmtx.unlock();
+
+	BulkStore &store(BulkStore::instance());
+	QByteArray data;
+	QStringList keys;
+	qint64 total = 0;
+	for (int i=0; i<files.size() && !openCancelled(); i++)
+	{
+		//
+		// modification time in the key keeps files replaced while the book was closed from being served stale
+		const QFileInfo finfo(files.at(i));
+		const QString key(files.at(i) + ":" + QString::number(finfo.lastModified().toMSecsSinceEpoch()));
+		if (store.get(key, data))
+		{
+			total += data.size();
+			keys.append(key);
+			continue;
+		}
+		QFile f(files.at(i));
+		//
+		// pages of other books are evicted, but not leading pages of this very book
+		total += finfo.size();
+		if (total > store.maxSize() || !f.open(QIODevice::ReadOnly))
+			break;
+		if (store.insert(key, f.readAll()))
+			keys.append(key);
+		else
+			keys.append(QString());
+		emit progress(i + 1, files.size());
+	}
+
+	listmtx.lock();
+	storekeys = keys;
+	listmtx.unlock();
+}
+
+void ImgDirSink::dropStored(int num)
+{
+	listmtx.lock();
+	QString key;
+	if (num >= 0 && num < storekeys.size())
+	{
+		key = storekeys.at(num);
+		storekeys[num] = QString();
+	}
+	listmtx.unlock();
+	if (!key.isEmpty())
+		BulkStore::instance().remove(key);
+}
+
 int ImgDirSink::numOfImages() const
 {
         listmtx.lock();
-        const int n = imgfiles.count();
+        const int n = imgfiles.size();
         listmtx.unlock();
         return n;
 }
@@ -214,7 +660,7 @@ int ImgDirSink::numOfImages() const
 QStringList ImgDirSink::getAllfiles() const
 {
         listmtx.lock();
-        QStringList l = imgfiles + txtfiles + otherfiles;
+        QStringList l = imgfiles.paths() + txtfiles.paths() + otherfiles.paths();
         listmtx.unlock();
         return l;
 }
@@ -227,30 +673,51 @@ QStringList ImgDirSink::getAlldirs() const
 QStringList ImgDirSink::getAllimgfiles() const
 {
         listmtx.lock();
-        const QStringList l = imgfiles;
+        const QStringList l = imgfiles.paths();
         listmtx.unlock();
         return l;
 }
 
 bool ImgDirSink::timestampDiffers(int page) const
 {
-	if (page < 0 || page > numOfImages())
-		return false;
 	listmtx.lock();
-	const QString fname = imgfiles[page];
+	if (page < 0 || page >= imgfiles.size())
+	{
+		listmtx.unlock();
+		return false;
+	}
+	if (watcher)
+	{
+		const bool d = dirty.contains(page);
+		listmtx.unlock();
+		return d;
+	}
+	const QString fname = imgfiles.path(page);
+	const bool loaded = imgfiles.hasTimestamp(page);
+	const QDateTime mtime = imgfiles.timestamp(page);
 	listmtx.unlock();
+	if (!loaded)
+		return false; // never shown, so can't be outdated
 	QFileInfo f(fname);
-	return f.lastModified() != timestamps[fname];
+	return f.lastModified() != mtime;
 }
 			
 bool ImgDirSink::hasModifiedFiles() const
 {
 	//
-	// check timestamps of all files
-	for (QMap<QString, FileStatus>::ConstIterator it = timestamps.begin(); it != timestamps.end(); ++it)
+	// check timestamps of all files loaded so far
+	listmtx.lock();
+	if (watcher)
 	{
-		QFileInfo finf(it.key());
-		if ((*it).isModified() || *it != finf.lastModified())
+		const bool m = rescan || !dirty.isEmpty();
+		listmtx.unlock();
+		return m;
+	}
+	const PageTable files(imgfiles);
+	listmtx.unlock();
+	for (int i=0; i<files.size(); i++)
+	{
+		if (files.hasTimestamp(i) && QFileInfo(files.path(i)).lastModified() != files.timestamp(i))
 			return true;
 	}
 	return false;
@@ -290,14 +757,8 @@ void ImgDirSink::removeThumbnails(int days)
 
 bool ImgDirSink::knownImageExtension(const QString &path)
 {
-    foreach (QString ext, ImageFormatsInfo::instance().extensions())
-    {
-        if (path.endsWith(ext, Qt::CaseInsensitive))
-        {
-            return true;
-        }
-    }
-    return false;
+    const int dot = path.lastIndexOf('.');
+    return dot >= 0 && ImageFormatsInfo::instance().hasSuffix(path.mid(dot + 1).toLower());
 }
 
 QString ImgDirSink::getKnownImageExtension(const QString &path)
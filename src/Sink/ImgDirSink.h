@@ -18,13 +18,20 @@
 #include <QString>
 #include <QStringList>
 #include <QDateTime>
-#include <QMap>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QSize>
 #include "DirReader.h"
 #include "ImgSink.h"
+#include "PageTable.h"
 #include "../Page.h"
 
 class QImage;
+class QFileSystemWatcher;
 
 namespace QComicBook
 {
@@ -38,36 +45,70 @@ namespace QComicBook
 		Q_OBJECT
 
 		protected:
-			class FileStatus
-			{
-				private:
-					bool modified;
-					QDateTime timestamp;
-				public:
-					FileStatus(): modified(false) {}
-					FileStatus(const QDateTime &mtime): modified(false), timestamp(mtime) {}
-					void set(const QDateTime &mtime, bool m) { timestamp = mtime; modified = m; }
-					bool isModified() const { return modified; }
-					bool operator==(const QDateTime &d) const { return d == timestamp; }
-					bool operator!=(const QDateTime &d) const { return d != timestamp; }
-					operator QDateTime() const { return timestamp; }
-			};
-
 			static QString memPrefix(int &s);
 
 			static const int MAX_TEXTFILE_SIZE;
+			static const int MIN_READAHEAD;
+			static const int MAX_READAHEAD;
+			static const int LATENCY_PROBE_SIZE;
 		
 			virtual bool fileHandler(const QFileInfo &finfo);
+			virtual bool visitCancelled() const;
+			virtual void batchDone();
 		
 		private:
+			class Scanner;
+			friend class Scanner;
+
 			mutable QMutex listmtx; //!< mutex for imgfiles
-			QStringList imgfiles; //!< list of images files in directory
-			QStringList txtfiles; //!< text files (.nfo, file_id.diz)
-			QStringList otherfiles; //!< list of other files
+			PageTable imgfiles; //!< images files in directory; also keeps timestamps of loaded pages
+			PageTable txtfiles; //!< text files (.nfo, file_id.diz)
+			PageTable otherfiles; //!< other files
 			QStringList dirs; //!< directories
 			QString dirpath; //!< path to directory
-			QMap<QString, FileStatus> timestamps; //!< last modifications timestamps for all pages
 			mutable QStringList desc; //txt files
+			QFileSystemWatcher *watcher; //!< reports changes of files and directories; NULL if not watching
+			QHash<QString, int> pageindex; //!< page number of image file; filled only when watching
+			QSet<int> dirty; //!< pages changed on disk since they were loaded
+			QVector<QSize> dims; //!< full-resolution dimensions of pages; invalid size if not known yet
+			QStringList storekeys; //!< BulkStore keys of pages read in bulk (path and modification time); empty if not stored
+			bool rescan; //!< files were added that don't fit at the end of page list
+			int readahead; //!< number of pages following the loaded one to read ahead
+			int advised; //!< pages up to this one were already read ahead
+			qint64 loadtime; //!< average time of reading a page file, in microseconds
+			Scanner *scanner; //!< thread listing the directory; NULL when not scanning
+			QWaitCondition scancond; //!< signaled when scanner finds pages or finishes
+			bool scanning; //!< scanner is listing the directory; guarded by listmtx
+			bool published; //!< open() returned; pages found since are announced with pagesAdded()
+			int announced; //!< number of pages announced so far; guarded by listmtx
+			QAtomicInt scanstop; //!< set by close() to stop the scanner
+			bool watchpending; //!< watchChanges() was called while scanning
+
+			//! Lists the directory; runs in scanner thread.
+			void scan();
+
+			//! Stops the scanner and waits for it.
+			void stopScan();
+
+			//! Asks kernel to read files of pages following num into page cache.
+			/*! Number of pages grows with observed read time, so slow media get a longer
+			 *  window. Nothing is decoded, so memory use doesn't change. */
+			void readAhead(unsigned int num, qint64 elapsed);
+
+			//! Reads files of all pages into BulkStore, in order, until they take the whole store.
+			void bulkReadPages();
+
+			//! Forgets page data kept in BulkStore, e.g. because the file changed.
+			void dropStored(int num);
+
+			//! Remembers full-resolution dimensions of the page.
+			void setPageSize(int num, const QSize &s);
+
+		private slots:
+			//! Starts watching changes requested during the scan.
+			void scanFinished();
+			void fileChanged(const QString &path);
+			void directoryChanged(const QString &path);
 
 		public:
 			ImgDirSink(bool dirs=false, int cacheSize=0);
@@ -76,7 +117,10 @@ namespace QComicBook
 			virtual ~ImgDirSink();
 
 			//! Opens this comic book sink with specifiled path.
-			/*! @param path comic book location
+			/*! Returns as soon as the first pages are found; the rest of the directory tree
+			 *  is listed in background and announced with pagesAdded() and pagesAvailable().
+			 *  In bulk read mode the whole tree is listed and read before returning.
+			 *  @param path comic book location
 			 *  @return value grater than 0 for error; 0 on success */
 			virtual int open(const QString &path);
 
@@ -84,12 +128,21 @@ namespace QComicBook
 			//! Closes this comic book sink cleaning resources.
 			virtual void close();
 
+			//! Watches files and directories of the book with QFileSystemWatcher.
+			/*! Changed pages are marked dirty and invalidated one by one, so hasModifiedFiles()
+			 *  and timestampDiffers() don't need to stat files anymore. Image files created
+			 *  after the last page of the book are appended as new pages. */
+			virtual void watchChanges();
+
 			//! Returns an image for specified page.
 			/*! The cache is first checked for image. If not found, the image is loaded.
 			 *  @param num page number
 			 *  @param result contains 0 on succes or value greater than 0 for error
 			 *  @return an image */
-			virtual QImage image(unsigned int num, int &result);
+			virtual QImage image(unsigned int num, int &result, const CancelToken *cancel = NULL);
+
+			//! Reads headers of image files to find dimensions of pages.
+			virtual QList<QSize> pageSizes(const QList<int> &nums);
 
 			/*! @return number of images for this comic book sink */
 			virtual int numOfImages() const;
@@ -12,6 +12,7 @@
 
 #include "ImgPdfSink.h"
 #include "../Page.h"
+#include "CancelToken.h"
 #include <QX11Info>
 #include <QFileInfo>
 #include <QMutexLocker>
@@ -54,10 +55,17 @@ void ImgPdfSink::close()
 	pdfdoc = 0;
 }
 
-QImage ImgPdfSink::image(unsigned int num, int &result)
+QImage ImgPdfSink::image(unsigned int num, int &result, const CancelToken *cancel)
 {
 	result = 1;
 	QMutexLocker lock(&docmtx);
+	//
+	// rendering can't be interrupted, but waiting for the document can be long
+	if (cancel && cancel->isCancelled())
+	{
+		result = SINKERR_CANCELLED;
+		return QImage();
+	}
 	if (pdfdoc)
 	{
 		Poppler::Page* pdfpage = pdfdoc->page(num);
@@ -28,7 +28,7 @@ namespace QComicBook
 
 			int open(const QString &path);
 			void close();
-			QImage image(unsigned int num, int &result);
+			QImage image(unsigned int num, int &result, const CancelToken *cancel = NULL);
 			int numOfImages() const;
 			QString getName(int maxlen = 50) { return ""; }
 			QString getFullName() const { return ""; }
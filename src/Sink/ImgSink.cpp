@@ -14,12 +14,32 @@
 #include "ImgCache.h"
 #include "../Page.h"
 #include "Thumbnail.h"
+#include "CancelToken.h"
 #include <QImage>
+#include <QImageReader>
+#include <QFile>
+#include <QMutexLocker>
 #include "../ComicBookDebug.h"
 
 using namespace QComicBook;
 
-ImgSink::ImgSink(int cacheSize): cbname(QString::null), cbfullname(QString::null), QObject()
+//
+// page being loaded by one thread, possibly awaited by others
+struct ImgSink::PendingLoad
+{
+	QImage image;
+	int result;
+	bool done;
+	int generation; //!< ImgSink::decodegen when the load started
+
+	PendingLoad(int generation): result(SINKERR_LOADERROR), done(false), generation(generation) {}
+};
+
+QAtomicInt ImgSink::sharedloads;
+QAtomicInt ImgSink::cancellableloads;
+QAtomicInt ImgSink::cancelledloads;
+
+ImgSink::ImgSink(int cacheSize): decodegen(0), bulk(false), cbname(QString::null), cbfullname(QString::null), QObject()
 {
 	cache = new ImgCache(cacheSize);
 }
@@ -30,32 +50,280 @@ ImgSink::~ImgSink()
     delete cache;
 }
 
+void ImgSink::cancelOpen()
+{
+	cancelled.storeRelease(1);
+}
+
+bool ImgSink::openCancelled() const
+{
+	return cancelled.loadAcquire() != 0;
+}
+
+void ImgSink::setBulkRead(bool f)
+{
+	bulk = f;
+}
+
+bool ImgSink::bulkRead() const
+{
+	return bulk;
+}
+
+bool ImgSink::setDecodeSize(int side)
+{
+	const int old = decodeside.fetchAndStoreOrdered(qMax(0, side));
+	//
+	// cached images are large enough unless the limit grows
+	if (old > 0 && (side <= 0 || side > old))
+	{
+		//
+		// loads in progress use the old size; they must not put their images back
+		QMutexLocker lock(&loadmtx);
+		++decodegen;
+		cache->clear();
+		return true;
+	}
+	return false;
+}
+
+int ImgSink::decodeSize() const
+{
+	return decodeside.loadAcquire();
+}
+
+QSize ImgSink::applyDecodeSize(QImageReader &reader) const
+{
+	const QSize full(reader.size());
+	const int side = decodeSize();
+	if (side <= 0 || !full.isValid())
+		return full;
+
+	//
+	// not worth resampling unless it saves a good share of pixels;
+	// JPEG reader scales in DCT domain so large reductions come almost for free
+	const int shorter = qMin(full.width(), full.height());
+	if (shorter > side + side/4)
+		reader.setScaledSize(QSize(qMax(1, static_cast<int>(static_cast<qint64>(full.width()) * side / shorter)),
+					   qMax(1, static_cast<int>(static_cast<qint64>(full.height()) * side / shorter))));
+	return full;
+}
+
+void ImgSink::watchChanges()
+{
+}
+
+QByteArray ImgSink::getPageData(int)
+{
+	return QByteArray();
+}
+
+QList<QSize> ImgSink::pageSizes(const QList<int> &nums)
+{
+	QList<QSize> sizes;
+	for (int i=0; i<nums.size(); i++)
+		sizes.append(QSize());
+	return sizes;
+}
+
+void ImgSink::invalidatePage(int num)
+{
+	cache->remove(num);
+	QFile::remove(Thumbnail(num, QString(cbname).remove('/')).getFullPath());
+	emit pageChanged(num);
+}
+
 void ImgSink::setCacheSize(int cacheSize, bool autoAdjust)
 {
 	cache->setSize(cacheSize, autoAdjust);
 }
 
-Page ImgSink::getImage(unsigned int num, int &result)
+ImgSink::LoadState ImgSink::beginLoad(unsigned int num, QImage &img, QSharedPointer<PendingLoad> &load)
 {
-	QImage im;
-	if (cache->get(num, im))
+	QMutexLocker lock(&loadmtx);
+	QMap<int, QSharedPointer<PendingLoad> >::const_iterator it = pending.constFind(num);
+	if (it != pending.constEnd())
 	{
-		result = 0;
-		_DEBUG << "from cache:" << num;
+		load = it.value();
+		return LoadInFlight;
 	}
-	else
+	//
+	// loader inserts into cache before it finishes, so checking cache under loadmtx can't miss the page
+	if (cache->get(num, img))
+		return LoadCached;
+	pending.insert(num, QSharedPointer<PendingLoad>(new PendingLoad(decodegen)));
+	return LoadOwned;
+}
+
+bool ImgSink::finishLoad(unsigned int num, const QImage &img, int result)
+{
+	QMutexLocker lock(&loadmtx);
+	QSharedPointer<PendingLoad> load(pending.take(num));
+	const bool current = !load || load->generation == decodegen;
+	if (result == 0 && current)
 	{
-		im = image(num, result); //TODO check result
-		cache->insertImage(num, im);
+		cache->insertImage(num, img);
 		_DEBUG << "to cache:" << num;
 	}
+	if (load)
+	{
+		load->image = img;
+		load->result = result;
+		load->done = true;
+	}
+	loadcond.wakeAll();
+	return current;
+}
+
+bool ImgSink::joinLoad(const QSharedPointer<PendingLoad> &load, QImage &img, int &result)
+{
+	QMutexLocker lock(&loadmtx);
+	while (!load->done)
+		loadcond.wait(&loadmtx);
+	img = load->image;
+	result = load->result;
+	sharedloads.ref();
+	return load->generation == decodegen;
+}
+
+int ImgSink::sharedLoads()
+{
+	return sharedloads.load();
+}
+
+int ImgSink::cancellableLoads()
+{
+	return cancellableloads.load();
+}
+
+int ImgSink::cancelledLoads()
+{
+	return cancelledloads.load();
+}
+
+bool ImgSink::isCancelled(const CancelToken *cancel)
+{
+	return cancel && cancel->isCancelled();
+}
+
+Page ImgSink::getImage(unsigned int num, int &result, const CancelToken *cancel)
+{
+	QImage im;
+	for (;;)
+	{
+		QSharedPointer<PendingLoad> load;
+		const LoadState state = beginLoad(num, im, load);
+		if (state == LoadCached)
+		{
+			result = 0;
+			_DEBUG << "from cache:" << num;
+			break;
+		}
+		if (state == LoadOwned)
+		{
+			if (cancel)
+				cancellableloads.ref();
+			im = image(num, result, cancel);
+			if (result == SINKERR_CANCELLED)
+			{
+				cancelledloads.ref();
+				_DEBUG << "cancelled:" << num;
+			}
+			//
+			// image decoded at the old decode size may be too small; load it again
+			if (finishLoad(num, im, result) || result != 0)
+				break;
+			continue;
+		}
+		const bool current = joinLoad(load, im, result);
+		_DEBUG << "shared load:" << num;
+		//
+		// thread that loaded the page gave up; load it here unless not needed either
+		if (result == SINKERR_CANCELLED ? isCancelled(cancel) : (current || result != 0))
+			break;
+	}
 	const Page page(num, im);
 	return page;
 }
 
+QList<QImage> ImgSink::images(const QList<int> &nums, QList<int> &results)
+{
+	QList<QImage> imgs;
+	results.clear();
+	foreach (int num, nums)
+	{
+		int result;
+		imgs.append(image(num, result));
+		results.append(result);
+	}
+	return imgs;
+}
+
+QList<Page> ImgSink::getImages(const QList<int> &nums, QList<int> &results)
+{
+	QList<Page> pages;
+	QList<int> missing; //pages to load
+	QList<int> positions; //positions of missing pages in nums
+	QList<QSharedPointer<PendingLoad> > others; //pages loaded by other threads
+	QList<int> otherpositions;
+	results.clear();
+	for (int i=0; i<nums.size(); i++)
+	{
+		QImage im;
+		QSharedPointer<PendingLoad> load;
+		const LoadState state = (missing.contains(nums.at(i)) ? LoadOwned : beginLoad(nums.at(i), im, load));
+		results.append(state == LoadCached ? 0 : SINKERR_LOADERROR);
+		if (state == LoadCached)
+			_DEBUG << "from cache:" << nums.at(i);
+		else if (state == LoadOwned)
+		{
+			missing.append(nums.at(i));
+			positions.append(i);
+		}
+		else
+		{
+			others.append(load);
+			otherpositions.append(i);
+		}
+		pages.append(Page(nums.at(i), im));
+	}
+
+	if (missing.size())
+	{
+		QList<int> res;
+		QList<int> stale; //positions of pages decoded at the old decode size
+		const QList<QImage> imgs(images(missing, res));
+		for (int i=0; i<missing.size(); i++)
+		{
+			const QImage im(i < imgs.size() ? imgs.at(i) : QImage());
+			const int r = i < res.size() ? res.at(i) : SINKERR_LOADERROR;
+			results[positions.at(i)] = r;
+			pages[positions.at(i)] = Page(missing.at(i), im);
+			if (!finishLoad(missing.at(i), im, r) && r == 0)
+				stale.append(positions.at(i));
+		}
+		foreach (int pos, stale)
+			pages[pos] = getImage(nums.at(pos), results[pos]);
+	}
+
+	//
+	// pages of other threads are awaited only after own ones are finished, so
+	// that two threads loading overlapping runs can't wait for each other
+	for (int i=0; i<others.size(); i++)
+	{
+		QImage im;
+		const bool current = joinLoad(others.at(i), im, results[otherpositions.at(i)]);
+		if (results.at(otherpositions.at(i)) == SINKERR_CANCELLED || (!current && results.at(otherpositions.at(i)) == 0))
+			pages[otherpositions.at(i)] = getImage(nums.at(otherpositions.at(i)), results[otherpositions.at(i)]);
+		else
+			pages[otherpositions.at(i)] = Page(nums.at(otherpositions.at(i)), im);
+	}
+	return pages;
+}
+
 Thumbnail ImgSink::getThumbnail(unsigned int num, bool thumbcache)
 {
-        Thumbnail t(num, cbname.remove('/'));
+        Thumbnail t(num, QString(cbname).remove('/'));
 
         //
         // try to load cached thumbnail
@@ -87,6 +355,47 @@ Thumbnail ImgSink::getThumbnail(unsigned int num, bool thumbcache)
 }
 
 
+QList<Thumbnail> ImgSink::getThumbnails(const QList<int> &nums, bool thumbcache)
+{
+	QList<Thumbnail> thumbs;
+	QList<int> missing;
+	QList<int> positions;
+	for (int i=0; i<nums.size(); i++)
+	{
+		Thumbnail t(nums.at(i), QString(cbname).remove('/'));
+		if (thumbcache && t.tryLoad())
+			_DEBUG << "thumbnail" << nums.at(i) << "loaded from disk";
+		else
+		{
+			missing.append(nums.at(i));
+			positions.append(i);
+		}
+		thumbs.append(t);
+	}
+
+	if (missing.size())
+	{
+		QList<int> results;
+		const QList<Page> pages(getImages(missing, results));
+		for (int i=0; i<pages.size(); i++)
+		{
+			if (results.at(i) == 0)
+			{
+				Thumbnail &t(thumbs[positions.at(i)]);
+				t.setImage(pages.at(i).getImage());
+				if (thumbcache)
+					t.save();
+			}
+		}
+	}
+	return thumbs;
+}
+
+int ImgSink::availableImages() const
+{
+	return numOfImages();
+}
+
 void ImgSink::setComicBookName(const QString &name, const QString &fullName)
 {
 	cbname = name;
@@ -14,14 +14,23 @@
 #define __IMGSINK_H
 
 #include <QObject>
+#include <QAtomicInt>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QSize>
 
 class QImage;
+class QImageReader;
 
 namespace QComicBook
 {
 	class Page;
 	class Thumbnail;
 	class ImgCache;
+	class CancelToken;
 
 	//! Possible errors.
 	enum SinkError
@@ -35,6 +44,7 @@ namespace QComicBook
 		SINKERR_NOTDIR,    //!<not a directory
 		SINKERR_EMPTY,     //!<no images inside
 		SINKERR_ARCHEXIT, //!<archiver exited with error
+		SINKERR_CANCELLED, //!<open or page load was cancelled
 		SINKERR_OTHER  //!<another kind of error
 	};
 		
@@ -49,6 +59,21 @@ namespace QComicBook
 			 *  @param total total number of steps */
 			void progress(int current, int total);
 
+			//! Emited when more pages can be read while comic book is still being opened.
+			/*! @param upto number of leading pages that are available now
+			 *  @see availableImages */
+			void pagesAvailable(int upto);
+
+			//! Emited when file of the page changed on disk after the book was opened.
+			/*! Cached image and thumbnail of the page are already dropped.
+			 *  @see watchChanges */
+			void pageChanged(int page);
+
+			//! Emited when new pages were appended after the book was opened.
+			/*! @param total number of pages now
+			 *  @see watchChanges */
+			void pagesAdded(int total);
+
 		public:
 			ImgSink(int cacheSize=0);
 
@@ -61,21 +86,65 @@ namespace QComicBook
 			 *  @return value grater than 0 for error; 0 on success */
 			virtual int open(const QString &path) = 0;
 
+			//! Requests open() in progress to stop as soon as possible.
+			/*! May be called from any thread; open() returns SINKERR_CANCELLED then.
+			 *  @see SinkOpener */
+			void cancelOpen();
+
+			//! @return true if cancelOpen() was called
+			bool openCancelled() const;
+
+			//! Enables bulk read mode for slow media (USB sticks, network shares).
+			/*! Must be set before open(). In this mode open() reads all pages in one sequential
+			 *  pass into BulkStore and pages are decoded from memory later. Pages that don't fit
+			 *  in the store are read from the medium on demand. */
+			void setBulkRead(bool f);
+			bool bulkRead() const;
+
+			//! Limits resolution pages are decoded at.
+			/*! Larger pages are decoded scaled down so that their shorter side has @p side pixels,
+			 *  which is enough for any fit mode on a screen whose longer side is @p side. Value of 0
+			 *  decodes pages at full resolution (e.g. for original size or printing).
+			 *  @return true if cached images were dropped because they may be too small now;
+			 *          pages on display should be requested again then */
+			bool setDecodeSize(int side);
+			int decodeSize() const;
+
 			//! Closes this comic book sink cleaning resources.
 			virtual void close() = 0;
 
+			//! Starts tracking changes of the opened book.
+			/*! Must be called from the thread the sink lives in; sink reports changes with
+			 *  pageChanged() and pagesAdded() then. Default implementation does nothing. */
+			virtual void watchChanges();
+
 
 			//! Returns given page. Has to be implemented by subclass.
-			/*!
+			/*! @param cancel if given and cancelled meanwhile, the load stops as soon as possible
+			 *                and result is SINKERR_CANCELLED
 			*/
-			virtual QImage image(unsigned int num, int &result) = 0;
+			virtual QImage image(unsigned int num, int &result, const CancelToken *cancel = NULL) = 0;
 
 			//! Returns an image for specified page.
 			/*! The cache is first checked for image. If not found, the image is loaded.
 			 *  @param num page number
 			 *  @param result contains 0 on succes or value greater than 0 for error
+			 *  @param cancel token for stopping the load; threads sharing the load load the page themselves then
 			 *  @return an image */
-			virtual Page getImage(unsigned int num, int &result);
+			virtual Page getImage(unsigned int num, int &result, const CancelToken *cancel = NULL);
+
+			//! Returns given pages; sinks may load them in one pass.
+			/*! Default implementation calls image() for every page.
+			 *  @param nums page numbers
+			 *  @param results receives 0 or error code for every page
+			 *  @return images in the order of nums */
+			virtual QList<QImage> images(const QList<int> &nums, QList<int> &results);
+
+			//! Returns images for specified pages, like getImage() does for one.
+			/*! Pages missing in the cache are loaded with a single images() call, so
+			 *  neighbouring pages of an archive can be decompressed together.
+			 *  @see images */
+			QList<Page> getImages(const QList<int> &nums, QList<int> &results);
 
 			//! Returns thumbnail image for specified page.
 			/*! Thumbnail is loaded from disk if found and caching is enabled. Otherwise,
@@ -84,8 +153,33 @@ namespace QComicBook
 			 *  @param thumbcache specifies if thumbnails disk cache should be used */
 			virtual Thumbnail getThumbnail(unsigned int num, bool thumbcache=true);
 
+			//! Returns thumbnails for specified pages; pages without cached thumbnail are loaded with getImages().
+			QList<Thumbnail> getThumbnails(const QList<int> &nums, bool thumbcache=true);
+
+			//! Returns full-resolution dimensions of given pages without decoding them.
+			/*! Only image headers are read and sizes found are remembered, so calling it again
+			 *  is cheap. Default implementation knows no sizes.
+			 *  @param nums page numbers
+			 *  @return dimensions in the order of nums; invalid size if not known */
+			virtual QList<QSize> pageSizes(const QList<int> &nums);
+
+			//! Returns number of page loads that were avoided because another thread was loading the same page.
+			static int sharedLoads();
+
+			//! Returns number of page loads started with cancel token.
+			static int cancellableLoads();
+
+			//! Returns number of page loads stopped with cancel token.
+			static int cancelledLoads();
+
 			/*! @return number of images for this comic book sink */
 			virtual int numOfImages() const = 0;
+
+			//! Returns number of leading pages that can be read right now.
+			/*! Sinks that publish their pages before all of them are ready (e.g. archive
+			 *  still being extracted) return less than numOfImages().
+			 *  @return number of available pages */
+			virtual int availableImages() const;
 			
 			void setComicBookName(const QString &name, const QString &fullName);
 
@@ -101,6 +195,11 @@ namespace QComicBook
 
 			virtual QString getFullFileName(int page) const = 0;
 
+			//! Returns file of the page as stored in the book, without decoding it.
+			/*! @return empty array if page has no such file or it can't be read; default
+			 *          implementation returns empty array, getFullFileName() is a file on disk then */
+			virtual QByteArray getPageData(int page);
+
 			/*! @return contents of .nfo and file_id.diz files; file name goes first, then contents. */
 			virtual QStringList getDescription() const = 0;
 
@@ -115,8 +214,50 @@ namespace QComicBook
 
 			virtual QString getPrevious() const = 0;
 
+		protected:
+			//! Drops cached image and thumbnail of the page and emits pageChanged().
+			void invalidatePage(int num);
+
+			//! Returns true if the load has to stop.
+			static bool isCancelled(const CancelToken *cancel);
+
+			//! Sets scaled size of reader according to setDecodeSize().
+			/*! @return dimensions of the image at full resolution; invalid size if unknown */
+			QSize applyDecodeSize(QImageReader &reader) const;
+
 		private:
+			struct PendingLoad;
+
+			//! State of a page for beginLoad().
+			enum LoadState
+			{
+				LoadCached, //!< page was found in the cache
+				LoadOwned, //!< caller has to load the page and call finishLoad()
+				LoadInFlight //!< another thread loads the page; wait for it with joinLoad()
+			};
+
+			//! Checks cache and pages being loaded; registers caller as the loader if page is in neither.
+			LoadState beginLoad(unsigned int num, QImage &img, QSharedPointer<PendingLoad> &load);
+			//! Caches result of the load started with beginLoad() and publishes it to threads waiting for it.
+			/*! @return false if decode size changed during the load; image is not cached then
+			 *          as it may be too small */
+			bool finishLoad(unsigned int num, const QImage &img, int result);
+			//! Waits for the load of another thread and takes its result.
+			/*! @return false if decode size changed during the load */
+			bool joinLoad(const QSharedPointer<PendingLoad> &load, QImage &img, int &result);
+
+			QMutex loadmtx; //!< mutex for pending and decodegen
+			QWaitCondition loadcond; //!< signaled when any pending load is finished
+			QMap<int, QSharedPointer<PendingLoad> > pending; //!< pages being loaded right now
+			static QAtomicInt sharedloads; //!< see sharedLoads()
+			static QAtomicInt cancellableloads; //!< see cancellableLoads()
+			static QAtomicInt cancelledloads; //!< see cancelledLoads()
+
 			ImgCache *cache;
+			QAtomicInt cancelled; //!< set by cancelOpen()
+			QAtomicInt decodeside; //!< see setDecodeSize()
+			int decodegen; //!< incremented when setDecodeSize() drops cached images; loads started before are stale
+			bool bulk; //!< bulk read mode; see setBulkRead()
 			QString cbname; //!< comic book name
 			QString cbfullname; //!< full comic book name (e.g. path)
 	};
@@ -14,6 +14,7 @@
 #include "ImgPdfSink.h"
 #include "ImgDirSink.h"
 #include "ImgArchiveSink.h"
+#include "FileTypeDetector.h"
 #include <QString>
 #include <QFileInfo>
 
@@ -54,7 +55,7 @@ QSharedPointer<ImgSink> ImgSinkFactory::createImgSink(const QString &path)
 	const QFileInfo finfo(path);
 	if (finfo.isDir())
 		return createImgSink(DirSink);
-	else if (path.endsWith("pdf")) //FIXME
+	else if (FileTypeDetector::detect(path) == FileTypeDetector::PdfFile)
 		return createImgSink(PdfSink);
 	else
 		return createImgSink(ArchiveSink);
@@ -0,0 +1,75 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "PageSizeProbe.h"
+#include "ImgSink.h"
+#include "../ComicBookDebug.h"
+
+using namespace QComicBook;
+
+const int PageSizeProbe::RUN_SIZE = 32;
+
+PageSizeProbe::PageSizeProbe(const QSharedPointer<ImgSink> &sink): QThread(), m_sink(sink)
+{
+	connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+}
+
+PageSizeProbe::~PageSizeProbe()
+{
+	_DEBUG;
+}
+
+void PageSizeProbe::cancel()
+{
+	cancelled.storeRelease(1);
+	mtx.lock();
+	cond.wakeAll();
+	mtx.unlock();
+}
+
+void PageSizeProbe::morePages()
+{
+	mtx.lock();
+	cond.wakeAll();
+	mtx.unlock();
+}
+
+bool PageSizeProbe::isCancelled() const
+{
+	return cancelled.loadAcquire() != 0;
+}
+
+void PageSizeProbe::run()
+{
+	int first = 0;
+	for (;;)
+	{
+		//
+		// sink announces pages after they became available, so checking under mtx can't miss them
+		mtx.lock();
+		int n;
+		while (!isCancelled() && (n = qMin(RUN_SIZE, m_sink->availableImages() - first)) <= 0)
+			cond.wait(&mtx);
+		mtx.unlock();
+		if (isCancelled())
+			break;
+
+		QList<int> nums;
+		for (int i=0; i<n; i++)
+			nums.append(first + i);
+		const QList<QSize> sizes(m_sink->pageSizes(nums));
+		if (!isCancelled())
+			emit sizesProbed(first, sizes);
+		first += n;
+	}
+	_DEBUG << first << "pages probed";
+}
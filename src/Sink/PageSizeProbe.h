@@ -0,0 +1,69 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file PageSizeProbe.h */
+
+#ifndef __PAGESIZEPROBE_H
+#define __PAGESIZEPROBE_H
+
+#include <QThread>
+#include <QList>
+#include <QSize>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+
+namespace QComicBook
+{
+	class ImgSink;
+
+	//! Finds dimensions of all pages of opened sink in a worker thread.
+	/*! Pages are probed with ImgSink::pageSizes(), in runs, so only image headers are read.
+	 *  Having probed all available pages, the probe waits for more (see morePages()) until
+	 *  cancelled, then deletes itself. */
+	class PageSizeProbe: public QThread
+	{
+		Q_OBJECT
+
+		signals:
+			//! Emited for every run of probed pages.
+			/*! @param first number of the first page
+			 *  @param sizes dimensions of subsequent pages; invalid size if not known */
+			void sizesProbed(int first, const QList<QSize> &sizes);
+
+		public:
+			PageSizeProbe(const QSharedPointer<ImgSink> &sink);
+			virtual ~PageSizeProbe();
+
+			//! Stops probing as soon as possible; may be called from any thread.
+			void cancel();
+			bool isCancelled() const;
+
+		public slots:
+			//! Resumes probing after the last probed page; connected to ImgSink::pagesAvailable() and ImgSink::pagesAdded().
+			void morePages();
+
+		protected:
+			virtual void run();
+
+		private:
+			static const int RUN_SIZE; //!< number of pages probed at once
+
+			QSharedPointer<ImgSink> m_sink;
+			QAtomicInt cancelled; //!< set by cancel()
+			QMutex mtx;
+			QWaitCondition cond; //!< signaled by morePages() and cancel()
+	};
+}
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "PageTable.h"
+
+using namespace QComicBook;
+
+const qint64 PageTable::NO_TIME = Q_INT64_C(-0x7fffffffffffffff) - 1;
+
+PageTable::PageTable()
+{
+}
+
+void PageTable::append(const QString &path)
+{
+	const int slash = path.lastIndexOf('/');
+	const QString dir(path.left(slash + 1)); //keeps trailing slash; empty for relative file name
+
+	Entry e;
+	//
+	// consecutive files come from the same directory most of the time
+	if (!dirs.isEmpty() && dirs.last() == dir)
+		e.dir = dirs.size() - 1;
+	else
+	{
+		QHash<QString, int>::const_iterator it = dirindex.constFind(dir);
+		if (it != dirindex.constEnd())
+			e.dir = it.value();
+		else
+		{
+			e.dir = dirs.size();
+			dirs.append(dir);
+			dirindex.insert(dir, e.dir);
+		}
+	}
+	e.offset = names.size();
+	e.length = path.size() - slash - 1;
+	e.mtime = NO_TIME;
+	names.append(path.midRef(slash + 1));
+	entries.append(e);
+}
+
+void PageTable::clear()
+{
+	dirs.clear();
+	dirindex.clear();
+	names.clear();
+	entries.clear();
+}
+
+int PageTable::size() const
+{
+	return entries.size();
+}
+
+bool PageTable::isEmpty() const
+{
+	return entries.isEmpty();
+}
+
+QString PageTable::path(int i) const
+{
+	const Entry &e(entries.at(i));
+	return dirs.at(e.dir) + names.midRef(e.offset, e.length);
+}
+
+QString PageTable::directory(int i) const
+{
+	return dirs.at(entries.at(i).dir);
+}
+
+QString PageTable::fileName(int i) const
+{
+	const Entry &e(entries.at(i));
+	return names.mid(e.offset, e.length);
+}
+
+QStringList PageTable::paths() const
+{
+	QStringList l;
+	l.reserve(entries.size());
+	for (int i=0; i<entries.size(); i++)
+		l.append(path(i));
+	return l;
+}
+
+QStringList PageTable::directories() const
+{
+	QStringList l;
+	foreach (const QString &d, dirs)
+	{
+		if (!d.isEmpty())
+			l.append(d.left(d.size() - 1));
+	}
+	return l;
+}
+
+void PageTable::setTimestamp(int i, const QDateTime &mtime)
+{
+	entries[i].mtime = mtime.isValid() ? mtime.toMSecsSinceEpoch() : NO_TIME;
+}
+
+bool PageTable::hasTimestamp(int i) const
+{
+	return entries.at(i).mtime != NO_TIME;
+}
+
+QDateTime PageTable::timestamp(int i) const
+{
+	const qint64 t = entries.at(i).mtime;
+	return t != NO_TIME ? QDateTime::fromMSecsSinceEpoch(t) : QDateTime();
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file PageTable.h */
+
+#ifndef __PAGETABLE_H
+#define __PAGETABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QDateTime>
+
+namespace QComicBook
+{
+	//! Compact list of file paths with per-file modification time.
+	/*! Directory part of every path is stored once and file names are kept in a single
+	 *  string, so big books in deep directories don't hold thousands of copies of the same
+	 *  prefix. Entries are addressed by index, which makes metadata lookups constant time.
+	 *  The class is not thread-safe. */
+	class PageTable
+	{
+		public:
+			PageTable();
+
+			//! Appends absolute file path.
+			void append(const QString &path);
+			void clear();
+			int size() const;
+			bool isEmpty() const;
+
+			QString path(int i) const;
+			//! @return directory of the file, with trailing slash
+			QString directory(int i) const;
+			QString fileName(int i) const;
+			QStringList paths() const;
+			//! @return distinct directories of all files, without trailing slash
+			QStringList directories() const;
+
+			//! Records modification time of the file.
+			void setTimestamp(int i, const QDateTime &mtime);
+			//! @return true if setTimestamp() was called for the file
+			bool hasTimestamp(int i) const;
+			QDateTime timestamp(int i) const;
+
+		private:
+			struct Entry
+			{
+				int dir; //!< index in dirs
+				int offset; //!< offset of file name in names
+				int length; //!< length of file name
+				qint64 mtime; //!< milliseconds since epoch; NO_TIME if not known
+			};
+
+			static const qint64 NO_TIME;
+
+			QStringList dirs; //!< distinct directories
+			QHash<QString, int> dirindex; //!< directory to index in dirs
+			QString names; //!< file names, one after another
+			QVector<Entry> entries;
+	};
+}
+
+#endif
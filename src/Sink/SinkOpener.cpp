@@ -0,0 +1,81 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "SinkOpener.h"
+#include "ImgSink.h"
+#include "../Page.h"
+#include "../ComicBookDebug.h"
+
+using namespace QComicBook;
+
+SinkOpener::SinkOpener(const QSharedPointer<ImgSink> &sink, const QString &path)
+	: QThread(), m_sink(sink), m_path(path), home(sink->thread()), status(SINKERR_OTHER), warmpages(0)
+{
+	m_sink->moveToThread(this);
+	connect(this, SIGNAL(finished()), this, SLOT(openFinished()));
+}
+
+SinkOpener::~SinkOpener()
+{
+	_DEBUG << m_path;
+}
+
+void SinkOpener::setWarmPages(int n)
+{
+	warmpages = n;
+}
+
+void SinkOpener::cancel()
+{
+	_DEBUG << m_path;
+	m_sink->cancelOpen();
+}
+
+bool SinkOpener::isCancelled() const
+{
+	return m_sink->openCancelled();
+}
+
+QSharedPointer<ImgSink> SinkOpener::sink() const
+{
+	return m_sink;
+}
+
+QString SinkOpener::path() const
+{
+	return m_path;
+}
+
+void SinkOpener::run()
+{
+	status = m_sink->open(m_path);
+	if (status == 0)
+	{
+		const int n = qMin(warmpages, m_sink->availableImages());
+		for (int i=0; i<n && !isCancelled(); i++)
+		{
+			int result;
+			m_sink->getImage(i, result);
+		}
+	}
+	//
+	// sink is used (and deleted) in the thread it was created in
+	m_sink->moveToThread(home);
+}
+
+void SinkOpener::openFinished()
+{
+	wait();
+	if (!isCancelled())
+		emit opened(status);
+	deleteLater();
+}
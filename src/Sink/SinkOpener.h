@@ -0,0 +1,70 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+/*! \file SinkOpener.h */
+
+#ifndef __SINKOPENER_H
+#define __SINKOPENER_H
+
+#include <QThread>
+#include <QString>
+#include <QSharedPointer>
+
+namespace QComicBook
+{
+	class ImgSink;
+
+	//! Opens comic book sink in a worker thread.
+	/*! The sink is moved to the worker thread for the time of ImgSink::open() and moved back
+	 *  to the thread it was created in afterwards. Sink's progress() signal may be used to
+	 *  follow the open as usual. The opener deletes itself when open is done; a cancelled
+	 *  opener doesn't emit opened() and releases the sink once ImgSink::open() returns. */
+	class SinkOpener: public QThread
+	{
+		Q_OBJECT
+
+		signals:
+			//! Emited in the thread of the opener when open is done, unless it was cancelled.
+			/*! @param status value returned by ImgSink::open() */
+			void opened(int status);
+
+		public:
+			SinkOpener(const QSharedPointer<ImgSink> &sink, const QString &path);
+			virtual ~SinkOpener();
+
+			//! Makes the opener load given number of leading pages into the sink cache after open.
+			/*! Used for speculative opens; has to be called before start(). */
+			void setWarmPages(int n);
+
+			//! Stops the open as soon as possible; may be called from any thread.
+			void cancel();
+			bool isCancelled() const;
+
+			QSharedPointer<ImgSink> sink() const;
+			QString path() const;
+
+		protected:
+			virtual void run();
+
+		private slots:
+			void openFinished();
+
+		private:
+			QSharedPointer<ImgSink> m_sink;
+			QString m_path;
+			QThread *home; //!< thread the sink is moved back to
+			int status; //!< result of ImgSink::open()
+			int warmpages; //!< number of pages to load after open
+	};
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#include "SinkReaper.h"
+#include <QDir>
+#include <QMutexLocker>
+#include "../ComicBookDebug.h"
+
+using namespace QComicBook;
+
+SinkReaper::SinkReaper(): QThread(), m_stopped(false)
+{
+}
+
+SinkReaper::~SinkReaper()
+{
+}
+
+SinkReaper* SinkReaper::create()
+{
+    SinkReaper *reaper = new SinkReaper();
+    reaper->start(QThread::LowPriority);
+    return reaper;
+}
+
+SinkReaper* SinkReaper::get()
+{
+    //
+    // sinks are closed in opener threads too; initialization of local static happens once
+    static SinkReaper *reaper = create();
+    return reaper;
+}
+
+void SinkReaper::remove(const Tree &t)
+{
+    _DEBUG << "removing" << t.files.size() << "files of" << t.path;
+    QDir dir(t.path);
+    foreach (const QString f, t.files)
+    {
+        dir.remove(f);
+    }
+    foreach (const QString d, t.dirs)
+    {
+        dir.rmdir(d);
+    }
+    dir.rmdir(t.path);
+}
+
+void SinkReaper::removeTree(const QString &path, const QStringList &files, const QStringList &dirs)
+{
+    Tree t;
+    t.path = path;
+    t.files = files;
+    t.dirs = dirs;
+
+    m_mtx.lock();
+    if (m_stopped)
+    {
+        //
+        // thread may be gone already; nothing would pick the tree up
+        m_mtx.unlock();
+        remove(t);
+        return;
+    }
+    m_trees.append(t);
+    m_mtx.unlock();
+    m_cond.wakeOne();
+}
+
+void SinkReaper::stop()
+{
+    _DEBUG;
+    QMutexLocker lock(&m_mtx);
+    m_stopped = true;
+    m_cond.wakeOne();
+}
+
+void SinkReaper::run()
+{
+    for (;;)
+    {
+        m_mtx.lock();
+        while (m_trees.isEmpty() && !m_stopped)
+        {
+            m_cond.wait(&m_mtx);
+        }
+        if (m_trees.isEmpty())
+        {
+            m_mtx.unlock();
+            break; // stopped and nothing left to remove
+        }
+        const Tree t = m_trees.takeFirst();
+        m_mtx.unlock();
+
+        remove(t);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is a part of QComicBook.
+ *
+ * Copyright (C) 2005-2010 Pawel Stolowski <stolowski@gmail.com>
+ *
+ * QComicBook is free software; you can redestribute it and/or modify it
+ * under terms of GNU General Public License by Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY. See GPL for more details.
+ */
+
+#ifndef __SINKREAPER_H
+#define __SINKREAPER_H
+
+#include <QThread>
+#include <QList>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace QComicBook
+{
+    //! Removes temporary files of closed sinks in background.
+    /*! Extracted archives may consist of thousands of files; removing them one by one
+     *  takes seconds on slow disks, which would otherwise delay opening the next book. */
+    class SinkReaper: public QThread
+    {
+    public:
+        SinkReaper();
+        ~SinkReaper();
+
+        //! Returns the reaper, starting it on first use; may be called from any thread.
+        static SinkReaper* get();
+
+        //! Queues removal of files, then directories (in given order) and finally the top directory.
+        /*! Once the reaper is stopped, files are removed right away in the calling thread.
+         *  @param path top directory
+         *  @param files files to remove, absolute or relative to path
+         *  @param dirs directories to remove, subdirectories first */
+        void removeTree(const QString &path, const QStringList &files, const QStringList &dirs);
+
+        //! Stops the thread after it removes everything queued so far.
+        void stop();
+
+    protected:
+        void run();
+
+    private:
+        struct Tree
+        {
+            QString path;
+            QStringList files;
+            QStringList dirs;
+        };
+
+        QMutex m_mtx;
+        QWaitCondition m_cond;
+        bool m_stopped;
+        QList<Tree> m_trees;
+
+        static SinkReaper* create();
+        static void remove(const Tree &t);
+    };
+}
+
+#endif
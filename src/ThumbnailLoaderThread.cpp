@@ -40,6 +40,21 @@ bool ThumbnailLoaderThread::process(const LoadRequest &req)
     return true;
 }
 
+bool ThumbnailLoaderThread::processRun(const QList<LoadRequest> &reqs)
+{
+    QList<int> nums;
+    foreach (const LoadRequest &req, reqs)
+    {
+        nums.append(req.pageNumber);
+    }
+    const QList<Thumbnail> thumbs(sink->getThumbnails(nums, usecache));
+    foreach (const Thumbnail &t, thumbs)
+    {
+        emit thumbnailLoaded(t);
+    }
+    return true;
+}
+
 void ThumbnailLoaderThread::setUseCache(bool f)
 {
     mtx.lock();
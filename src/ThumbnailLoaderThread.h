@@ -36,6 +36,7 @@ namespace QComicBook
         
     protected:
         virtual bool process(const LoadRequest &req);
+        virtual bool processRun(const QList<LoadRequest> &reqs);
         
     private:
         QMutex mtx;
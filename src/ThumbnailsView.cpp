@@ -73,6 +73,14 @@ void ThumbnailsView::setPages(int pages)
 	//setArrangement(visibleWidth() > visibleHeight() ? QIconView::LeftToRight : QIconView::TopToBottom);
 }
 
+void ThumbnailsView::addPages(int pages)
+{
+	for (int i=numpages; i<pages; i++)
+		icons.append(new IconViewThumbnail(this, i, *emptypage));
+	if (pages > numpages)
+		numpages = pages;
+}
+
 void ThumbnailsView::setPage(int n, const QPixmap &img)
 {
 	if (n < icons.count())
@@ -51,6 +51,8 @@ namespace QComicBook
 
 		public slots:
 			void setPages(int pages);
+			//! Appends empty thumbnails so that the view has given number of pages.
+			void addPages(int pages);
 			void setPage(int n, const QPixmap &img);
 			void setPage(const Thumbnail &t);
 			void clear();
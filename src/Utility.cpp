@@ -14,8 +14,11 @@
 #include <QCoreApplication>
 #include <QStringList>
 #include <QFileInfo>
+#include <QFile>
 #include <stdlib.h>
 #include <utime.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 QString Utility::which(const QString &command)
 {
@@ -44,6 +47,18 @@ void Utility::touch(const QString &fname)
     utime(fname.toLocal8Bit(), NULL);
 }
 
+void Utility::willNeed(const QString &path)
+{
+#ifdef POSIX_FADV_WILLNEED
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd >= 0)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        ::close(fd);
+    }
+#endif
+}
+
 QString Utility::shortenPath(const QString &path, const QString &filler, int maxlen)
 {
     if (path.length() > maxlen)
@@ -19,6 +19,7 @@ namespace Utility
 {
 	QString which(const QString &command); //similiar to shell 'which' command
         void touch(const QString &path);
+        void willNeed(const QString &path); //asks kernel to read file into page cache in background
         QString shortenPath(const QString &path, const QString &filler, int maxlen);
 }
 
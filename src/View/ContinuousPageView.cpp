@@ -151,6 +151,41 @@ void ContinuousPageView::recreateComicPageImages()
         }
         
         m_ypos.resize(imgLabel.size());
+        applyPageSizes();
+    }
+}
+
+void ContinuousPageView::setPageSizes(int first, const QList<QSize> &sizes)
+{
+    _DEBUG << first << sizes.size();
+    if (m_pageSizes.size() < first + sizes.size())
+    {
+        m_pageSizes.resize(first + sizes.size());
+    }
+    for (int i=0; i<sizes.size(); i++)
+    {
+        m_pageSizes[first + i] = sizes.at(i);
+    }
+    applyPageSizes();
+    recalculatePageSizes();
+}
+
+void ContinuousPageView::applyPageSizes()
+{
+    foreach (ComicPageImage *p, imgLabel)
+    {
+        const int n = p->pageNumber();
+        QSize s(n < m_pageSizes.size() ? m_pageSizes.at(n) : QSize());
+        if (p->hasTwoPages())
+        {
+            // two pages side by side, as in ComicPageImage::redrawImages
+            const QSize s2(n + 1 < m_pageSizes.size() ? m_pageSizes.at(n + 1) : QSize());
+            s = (s.isValid() && s2.isValid()) ? QSize(s.width() + s2.width(), std::max(s.height(), s2.height())) : QSize();
+        }
+        if (s.isValid())
+        {
+            p->setKnownSize(s);
+        }
     }
 }
 
@@ -196,7 +231,7 @@ void ContinuousPageView::disposeOrRequestPages()
             _DEBUG << "in view:" << w->pageNumber();
             if (w->isDisposed())
             {
-                if (!hasRequest(w->pageNumber()))
+                if (!hasRequest(w->pageNumber()) || isPreloaded(w->pageNumber()))
                 {
                     _DEBUG << "requesting" << w->pageNumber();
                     addRequest(w->pageNumber(), props.twoPagesMode() && w->hasTwoPages());
@@ -238,7 +273,7 @@ void ContinuousPageView::disposeOrRequestPages()
                     if (cfg.preloadPages())
                     {
                         _DEBUG << "preloading" << w->pageNumber();
-                        addRequest(w->pageNumber(), props.twoPagesMode() && w->hasTwoPages());
+                        addRequest(w->pageNumber(), props.twoPagesMode() && w->hasTwoPages(), true);
                     }
                 }
                 else
@@ -449,6 +484,7 @@ void ContinuousPageView::scrollToBottom()
 void ContinuousPageView::clear()
 {
     m_firstVisible = -1;
+    m_pageSizes.clear();
     delRequests();
     setNumOfPages(0);
 }
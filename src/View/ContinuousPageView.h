@@ -36,6 +36,7 @@ namespace QComicBook
         void recreateComicPageImages();
         ComicPageImage *findComicPageImage(int pageNum) const;
         void recalculatePageSizes();
+        void applyPageSizes();
         QList<ComicPageImage *> findComicPageImagesInView() const;
         void disposeOrRequestPages();
         ComicPageImage *currentComicPageImage() const;
@@ -58,6 +59,7 @@ namespace QComicBook
         virtual void scrollToTop();
         virtual void scrollToBottom();
         virtual void setGapSize(int f);
+        virtual void setPageSizes(int first, const QList<QSize> &sizes);
         
     public:
         ContinuousPageView(QWidget *parent, int physicalPages, const ViewProperties& props);
@@ -71,6 +73,7 @@ namespace QComicBook
     private:
         QVector<ComicPageImage*> imgLabel;
         CoordinateRangeList<int> m_ypos;
+        QVector<QSize> m_pageSizes; //probed dimensions of physical pages
         int m_requestedPage; //page requested by call to gotoPage
         int m_firstVisible; //first visible page in the view
         double m_firstVisibleOffset; //visible portion (%) of first visible page
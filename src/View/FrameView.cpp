@@ -138,7 +138,7 @@ void FrameView::gotoPage(int n)
         {   
             ++n;
             _DEBUG << "preloading" << n;            
-            addRequest(n, false);
+            addRequest(n, false, true);
         }
     }
 }
@@ -295,6 +295,10 @@ int PageViewBase::numOfPages() const
     return m_physicalPages;
 }
 
+void PageViewBase::setPageSizes(int first, const QList<QSize> &sizes)
+{
+}
+
 void PageViewBase::setRotation(Rotation r)
 {
     props.setAngle(r);
@@ -410,13 +414,27 @@ bool PageViewBase::hasRequest(int page) const
     return m_requestedPages.indexOf(page) >= 0;
 }
 
-void PageViewBase::addRequest(int page, bool twoPages)
+bool PageViewBase::isPreloaded(int page) const
+{
+    return m_preloadedPages.indexOf(page) >= 0;
+}
+
+void PageViewBase::addRequest(int page, bool twoPages, bool preload)
 {
-    m_requestedPages.append(page);
-    if (twoPages)
-        emit requestTwoPages(page);
+    if (m_requestedPages.indexOf(page) < 0)
+    {
+        m_requestedPages.append(page);
+        if (preload)
+            m_preloadedPages.append(page);
+    }
+    else if (preload || m_preloadedPages.removeAll(page) == 0)
+    {
+        return; // already requested
+    }
+    if (preload)
+        emit twoPages ? preloadTwoPages(page) : preloadPage(page);
     else
-        emit requestPage(page);
+        emit twoPages ? requestTwoPages(page) : requestPage(page);
 }
 
 void PageViewBase::delRequest(int page, bool twoPages, bool cancel)
@@ -425,6 +443,7 @@ void PageViewBase::delRequest(int page, bool twoPages, bool cancel)
     if (idx >= 0)
     {
         m_requestedPages.removeAt(idx);
+        m_preloadedPages.removeAll(page);
         if (cancel)
         {
             if (twoPages)
@@ -473,6 +492,7 @@ int PageViewBase::roundPageNumber(int page) const
 void PageViewBase::delRequests()
 {
     m_requestedPages.clear();
+    m_preloadedPages.clear();
 }
 
 void PageViewBase::recalculateScrollSpeeds()
@@ -14,6 +14,8 @@
 #define __PAGEVIEWBASE_H
 
 #include <QGraphicsView>
+#include <QList>
+#include <QSize>
 #include "ViewProperties.h"
 #include <ComicFrame.h>
 
@@ -41,6 +43,8 @@ namespace QComicBook
             void doubleClick();
             void requestPage(int);
             void requestTwoPages(int);
+            void preloadPage(int);
+            void preloadTwoPages(int);
             void cancelPageRequest(int);
             void cancelTwoPagesRequest(int);
             void pageReady(const Page&);
@@ -79,6 +83,11 @@ namespace QComicBook
             virtual void scrollLeft();
             virtual void scrollRightFast();
             virtual void scrollLeftFast();
+            //! Sets dimensions of pages known before the pages are loaded.
+            /*! Used by views that lay out pages not loaded yet; default implementation does nothing.
+             *  @param first number of the first page
+             *  @param sizes full-resolution dimensions of subsequent pages; invalid size if not known */
+            virtual void setPageSizes(int first, const QList<QSize> &sizes);
             virtual void propsChanged() = 0;
 
         protected slots:
@@ -116,7 +125,11 @@ namespace QComicBook
             void updateSceneRect();
 
             bool hasRequest(int page) const;
-            void addRequest(int page, bool twoPages);
+            bool isPreloaded(int page) const;
+            //! Requests page from the loader.
+            /*! @param preload if true, page is requested ahead of time and goes after pages requested for display;
+             *                 requesting preloaded page again without this flag makes it urgent */
+            void addRequest(int page, bool twoPages, bool preload=false);
             void delRequest(int page, bool twoPages, bool cancel=true);
             void delRequests();
 
@@ -133,6 +146,7 @@ namespace QComicBook
             QCursor *smallcursor;
             Lens *lens;
             QList<int> m_requestedPages;
+            QList<int> m_preloadedPages; //requested pages that are only preloaded
         };
 }
 
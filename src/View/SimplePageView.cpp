@@ -152,7 +152,7 @@ void SimplePageView::gotoPage(int n)
         {   
             n = nextPage(n);
             _DEBUG << "preloading" << n;            
-            addRequest(n, props.twoPagesMode() && n < numOfPages()); // request two pages if not last page
+            addRequest(n, props.twoPagesMode() && n < numOfPages(), true); // request two pages if not last page
         }
     }
 }
@@ -4,4 +4,7 @@
 #define DATADIR "@CMAKE_INSTALL_PREFIX@/share/@PACKAGE@"
 #define VERSION "@VERSION@"
 
+#cmakedefine HAVE_LIBARCHIVE 1
+#cmakedefine HAVE_ZLIB 1
+
 #endif
\ No newline at end of file
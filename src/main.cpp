@@ -17,6 +17,8 @@
 #include <QLibraryInfo>
 #include <QTranslator>
 #include <QLocale>
+#include <QList>
+#include <QSize>
 #include "ComicMainWindow.h"
 #include "ComicBookSettings.h"
 #include "ComicFrameList.h"
@@ -50,6 +52,7 @@ int main(int argc, char *argv[])
         qRegisterMetaType<Thumbnail>("Thumbnail");
         qRegisterMetaType<ComicFrameList>("ComicFrameList");
         qRegisterMetaType<ImageJobResult>("ImageJobResult");
+        qRegisterMetaType<QList<QSize> >("QList<QSize>");
 
 	ComicBookSettings::instance().load();
 